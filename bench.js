@@ -0,0 +1,52 @@
+// Times the recognition of whole pages with each build of Ocrad.js found
+// (ocrad.js, ocrad-wasm.js, ocrad-mt.js), on the pages used by the
+// native 'make bench': the test page of ocrad, or the pnm files given,
+// each at its own size and scaled by 2.
+//
+// Usage: node bench.js [--threads=<n>] [files.pnm...]
+var fs = require('fs');
+var path = require('path');
+
+var runs = 5, threads = 0, files = [];
+process.argv.slice(2).forEach(function(arg){
+	var m = arg.match(/^--threads=(\d+)$/);
+	if(m) threads = parseInt(m[1]);
+	else files.push(arg);
+});
+if(!files.length) files.push(path.join(__dirname, 'ocrad-0.25', 'testsuite', 'test.pbm'));
+
+// Returns the time in ms of one recognition, and the characters found
+function recognize(OCRAD, image, scale, threads){
+	OCRAD.write_file('/bench.pnm', image);
+	var desc = OCRAD.open();
+	var start = process.hrtime();
+	if(OCRAD.set_image_from_file(desc, '/bench.pnm', 0) < 0 ||
+	   (scale != 1 && OCRAD.scale(desc, scale) < 0) ||
+	   (OCRAD.set_threads && OCRAD.set_threads(desc, threads) < 0) ||
+	   OCRAD.recognize(desc, 0) < 0)
+		throw 'recognition failed, errno ' + OCRAD.get_errno(desc);
+	var t = process.hrtime(start);
+	var chars = OCRAD.result_chars_total(desc);
+	OCRAD.close(desc);
+	OCRAD.delete_file('/bench.pnm');
+	return { ms: t[0] * 1e3 + t[1] / 1e6, chars: chars };
+}
+
+['ocrad.js', 'ocrad-wasm.js', 'ocrad-mt.js'].forEach(function(build){
+	var OCRAD;
+	try { OCRAD = require('./' + build); OCRAD.preinit(); }
+	catch (e) { console.log(build + ': not available (' + (e.code || e) + ')'); return; }
+	console.log(build + ':');
+	files.forEach(function(file){
+		var image = new Uint8Array(fs.readFileSync(file));
+		[1, 2].forEach(function(scale){
+			var r = recognize(OCRAD, image, scale, threads); // warm up
+			var times = [];
+			for(var i = 0; i < runs; i++) times.push(recognize(OCRAD, image, scale, threads).ms);
+			times.sort(function(a, b){ return a - b });
+			console.log('  ' + path.basename(file) + (scale != 1 ? ' x ' + scale : '') +
+			            ': ' + times[runs >> 1].toFixed(1) + ' ms (median of ' + runs +
+			            '), ' + r.chars + ' chars');
+		});
+	});
+});
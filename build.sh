@@ -2,6 +2,10 @@
 PATH="$HOME/emsdk_portable:$HOME/emsdk_portable/clang/fastcomp/build_master_64/bin:$HOME/emsdk_portable/node/4.1.1_64bit/bin:$HOME/emsdk_portable/emscripten/master:/usr/local/bin:/usr/bin:/bin:/usr/local/games:/usr/games"
 EMSCRIPTEN="$HOME/emsdk_portable/emscripten/master"
 
+# functions of ocradlib called from src/post.js
+EXPORTS="['_OCRAD_set_exportfile', '_OCRAD_transform', '_OCRAD_add_filter', '_OCRAD_add_user_filter', '_OCRAD_clear_filters', '_OCRAD_apply_filters', '_OCRAD_version', '_OCRAD_open', '_OCRAD_close', '_OCRAD_get_errno', '_OCRAD_set_image', '_OCRAD_set_image_from_file', '_OCRAD_next_image', '_OCRAD_set_utf8_format', '_OCRAD_set_threads', '_OCRAD_set_despeckle', '_OCRAD_set_coarse_layout', '_OCRAD_set_quality', '_OCRAD_set_trace_file', '_OCRAD_set_incremental', '_OCRAD_set_cache', '_OCRAD_set_memory_limit', '_OCRAD_set_threshold', '_OCRAD_set_adaptive_threshold', '_OCRAD_scale', '_OCRAD_auto_scale', '_OCRAD_recognize', '_OCRAD_recognize_sweep', '_OCRAD_result_select', '_OCRAD_result_score', '_malloc', '_free', '_OCRAD_result_blocks', '_OCRAD_result_lines', '_OCRAD_result_chars_total', '_OCRAD_result_chars_block', '_OCRAD_result_chars_line', '_OCRAD_result_line', '_OCRAD_result_line_table', '_OCRAD_result_first_character', '_OCRAD_result_memory_peak']"
+OBJS="ocradlib.o page_image_io.o page_image.o rectangle.o textpage.o bitplane.o bitmap.o blob.o textblock.o character_r11.o frame_cache.o result_cache.o ucs.o character.o textline.o track.o rational.o profile.o mask.o feats.o common.o parallel.o feats_test0.o feats_test1.o rule_stats.o trace.o segment.o character_r12.o character_r13.o textline_r2.o textblock.o textpage.o arg_parser.o user_filter.o iso_8859.o"
+
 # autogenerate some parts of the postcode
 python src/generate.py
 
@@ -9,5 +13,28 @@ python src/generate.py
 cd ocrad-*
 emconfigure ./configure
 emmake make
-emcc -02 --memory-init-file 0 -v -s TOTAL_MEMORY=33554432 -s EXPORTED_FUNCTIONS="['_OCRAD_set_exportfile', '_OCRAD_transform', '_OCRAD_add_filter', '_OCRAD_version', '_OCRAD_open', '_OCRAD_close', '_OCRAD_get_errno', '_OCRAD_set_image', '_OCRAD_set_image_from_file', '_OCRAD_set_utf8_format', '_OCRAD_set_threshold', '_OCRAD_scale', '_OCRAD_recognize', '_OCRAD_result_blocks', '_OCRAD_result_lines', '_OCRAD_result_chars_total', '_OCRAD_result_chars_block', '_OCRAD_result_chars_line', '_OCRAD_result_line', '_OCRAD_result_first_character']" ocradlib.o page_image_io.o page_image.o rectangle.o textpage.o bitmap.o blob.o textblock.o character_r11.o ucs.o character.o textline.o track.o rational.o profile.o mask.o feats.o common.o feats_test0.o feats_test1.o segment.o character_r12.o character_r13.o textline_r2.o textblock.o textpage.o arg_parser.o user_filter.o iso_8859.o -o ../ocrad.js --pre-js ../src/pre.js --post-js ../src/post.js
+emcc -02 --memory-init-file 0 -v -s TOTAL_MEMORY=33554432 -s EXPORTED_FUNCTIONS="$EXPORTS" $OBJS -o ../ocrad.js --pre-js ../src/pre.js --post-js ../src/post.js
+make clean
+
+# WebAssembly build with SIMD and growable memory, for images too large
+# for the fixed heap of ocrad.js. The module is compiled synchronously,
+# which browsers only allow in workers; use the asynchronous API there.
+WASM_FLAGS="-O3 -msimd128"
+WASM_LINK="-s WASM=1 -s ALLOW_MEMORY_GROWTH=1 -s MAXIMUM_MEMORY=2147483648 -s WASM_ASYNC_COMPILATION=0"
+emmake make CXXFLAGS="$WASM_FLAGS"
+emcc $WASM_FLAGS $WASM_LINK -s SINGLE_FILE=1 -s EXPORTED_FUNCTIONS="$EXPORTS" $OBJS -o ../ocrad-wasm.js --pre-js ../src/pre.js --post-js ../src/post.js
 make clean
+
+# Same with threads, which need SharedArrayBuffer (Node, or pages that are
+# cross-origin isolated). Threads are taken from a fixed pool. Threads
+# asked for by OCRAD_set_threads beyond the pool fail to start and their
+# work is done by the threads already running. ocrad-auto.js doesn't load
+# this build until bench.js has shown it to be faster than ocrad-wasm.js.
+emmake make CXXFLAGS="$WASM_FLAGS -pthread"
+emcc $WASM_FLAGS -pthread $WASM_LINK -s PTHREAD_POOL_SIZE=4 -s PTHREAD_POOL_SIZE_STRICT=2 -s EXPORTED_FUNCTIONS="$EXPORTS" $OBJS -o ../ocrad-mt.js --pre-js ../src/pre.js --post-js ../src/post.js
+make clean
+cd ..
+
+# time each build on the test page, serial and with 4 threads
+node bench.js
+node bench.js --threads=4
@@ -0,0 +1,446 @@
+/*  GNU Ocrad - Optical Character Recognition program
+    Copyright (C) 2003-2015 Antonio Diaz Diaz.
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 2 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <new>
+#include <vector>
+#include <stdint.h>
+
+#include "common.h"
+#include "rectangle.h"
+#include "bitplane.h"
+#include "page_image.h"
+#include "parallel.h"
+
+
+namespace {
+
+// Returns the index of the lowest bit set in 'x' (x != 0).
+inline int lowest_bit( uint64_t x )
+  {
+#if defined(__GNUC__)
+  return __builtin_ctzll( x );
+#else
+  int i = 0;
+  if( !( x & 0xFFFFFFFFU ) ) { x >>= 32; i += 32; }
+  if( !( x & 0xFFFF ) ) { x >>= 16; i += 16; }
+  if( !( x & 0xFF ) ) { x >>= 8; i += 8; }
+  while( !( x & 1 ) ) { x >>= 1; ++i; }
+  return i;
+#endif
+  }
+
+
+// Returns the number of bits set in 'x'.
+inline int count_bits( uint64_t x )
+  {
+#if defined(__GNUC__)
+  return __builtin_popcountll( x );
+#else
+  int i = 0;
+  for( ; x; x &= x - 1 ) ++i;
+  return i;
+#endif
+  }
+
+
+// Returns the index of the highest bit set in 'x' (x != 0).
+inline int highest_bit( uint64_t x )
+  {
+#if defined(__GNUC__)
+  return 63 - __builtin_clzll( x );
+#else
+  int i = 0;
+  while( x >>= 1 ) ++i;
+  return i;
+#endif
+  }
+
+
+struct Sauvola
+  {
+  Bitplane & bitplane;
+  const Page_image & page_image;
+  const int window;
+  const int bands;
+  std::vector< char > failed;			// band ran out of memory
+
+  Sauvola( Bitplane & b, const Page_image & p, const int w, const int n )
+    : bitplane( b ), page_image( p ), window( w ), bands( n ), failed( n, 0 ) {}
+  };
+
+} // end namespace
+
+
+// Sauvola's threshold for a pixel is  t = m * ( 1 + k * ( s / R - 1 ) ),
+// where m and s are the mean and standard deviation of the pixels of the
+// window around it, clipped to the image, k = 0.34 and R is half the
+// maxval. The sums of the values and of their squares over the window
+// rows are kept per column, adding and removing one row as the window
+// moves down. A prefix sum of them (the row of the integral image) gives
+// then the sums over each window in O(1). Memory use is proportional to
+// the width of the image. The test  v <= t  is done without square root
+// as  v - m * ( 1 - k ) <= 0  or  ( v - m * ( 1 - k ) )^2 * R^2 <=
+// ( m * k )^2 * s^2.
+//
+void Bitplane::sauvola_band( const Page_image & page_image, const int window,
+                             const int first_row, const int last_row )
+  {
+  const double k = 0.34, R = page_image.maxval() / 2.0;
+  const double R2 = R * R, k2 = k * k;
+  const int half = window / 2;
+  const int w = width();
+  std::vector< uint32_t > col( w, 0 ), col2( w, 0 );	// window column sums
+  std::vector< uint64_t > sum( w + 1, 0 ), sum2( w + 1, 0 );	// prefix sums
+  std::vector< int > c1( w ), c2( w );		// columns of the window
+  std::vector< double > inv_cols( w );
+  for( int i = 0; i < w; ++i )
+    {
+    c1[i] = std::max( 0, i - half ); c2[i] = std::min( w, i + half + 1 );
+    inv_cols[i] = 1.0 / ( c2[i] - c1[i] );
+    }
+
+  int t = std::max( top(), first_row - half );		// window rows
+  int b = t - 1;
+  for( int row = first_row; row <= last_row; ++row )
+    {
+    for( ; b < std::min( bottom(), row + half ); ++b )	// add rows
+      for( int i = 0; i < w; ++i )
+        {
+        const uint32_t v = page_image.get_value( b + 1, left() + i );
+        col[i] += v; col2[i] += v * v;
+        }
+    for( ; t < row - half; ++t )			// remove rows
+      for( int i = 0; i < w; ++i )
+        {
+        const uint32_t v = page_image.get_value( t, left() + i );
+        col[i] -= v; col2[i] -= v * v;
+        }
+    for( int i = 0; i < w; ++i )
+      { sum[i+1] = sum[i] + col[i]; sum2[i+1] = sum2[i] + col2[i]; }
+
+    const double inv_rows = 1.0 / ( b - t + 1 );
+    uint64_t * const p = row_data( row );
+    for( int word = 0; word < words_; ++word )
+      {
+      const int l = 64 * word;
+      const int r = std::min( w - 1, l + 63 );
+      uint64_t x = 0;
+      for( int i = r; i >= l; --i )
+        {
+        const int a = c1[i], z = c2[i];
+        const double inv_n = inv_rows * inv_cols[i];
+        const double mean = ( sum[z] - sum[a] ) * inv_n;
+        const double var = ( sum2[z] - sum2[a] ) * inv_n - mean * mean;
+        const double d = page_image.get_value( row, left() + i ) - mean * ( 1 - k );
+        const bool black = ( d <= 0 || d * d * R2 <= mean * mean * k2 * var );
+        x = ( x << 1 ) | black;
+        }
+      p[word] = x;
+      }
+    }
+  }
+
+
+void Bitplane::sauvola_job( void * const arg, const int i )
+  {
+  Sauvola & sv = *(Sauvola *)arg;
+  Bitplane & bp = sv.bitplane;
+  const int rows = ( bp.height() + sv.bands - 1 ) / sv.bands;
+  const int first = bp.top() + i * rows;
+  const int last = std::min( bp.bottom(), first + rows - 1 );
+  try
+    {
+    if( first <= last )
+      bp.sauvola_band( sv.page_image, sv.window, first, last );
+    }
+  catch( std::bad_alloc ) { sv.failed[i] = 1; }
+  }
+
+
+Bitplane::Bitplane( const Page_image & page_image, const int threshold,
+                    const int window, const int threads )
+  : Rectangle( page_image ), words_( ( page_image.width() + 63 ) / 64 )
+  {
+  data.resize( height() * words_ );
+  if( window > 0 && page_image.maxval() > 1 )
+    {
+    // bands of at least 256 rows, as each one reads 'window' extra rows
+    const int bands = std::max( 1, std::min( height() / 256, 4 * threads ) );
+    Sauvola sv( *this, page_image, window, bands );
+    Ocrad::parallel_run( sauvola_job, &sv, bands, threads );
+    if( std::find( sv.failed.begin(), sv.failed.end(), 1 ) != sv.failed.end() )
+      throw std::bad_alloc();
+    return;
+    }
+  const uint8_t th = ( threshold >= 0 ) ? threshold : page_image.threshold();
+  for( int row = top(); row <= bottom(); ++row )
+    {
+    uint64_t * const p = row_data( row );
+    for( int w = 0; w < words_; ++w )
+      {
+      const int l = left() + 64 * w;
+      const int r = std::min( right(), l + 63 );
+      uint64_t x = 0;
+      for( int col = r; col >= l; --col )
+        x = ( x << 1 ) | page_image.get_bit( row, col, th );
+      p[w] = x;
+      }
+    }
+  }
+
+
+long Bitplane::ink() const
+  {
+  long sum = 0;
+  for( unsigned i = 0; i < data.size(); ++i ) sum += count_bits( data[i] );
+  return sum;
+  }
+
+
+int Bitplane::black_pixels( const int row, const int first_col,
+                            const int last_col ) const
+  {
+  const uint64_t * const p = row_data( row );
+  const int first = first_col - left(), last = last_col - left();
+  int sum = 0;
+  for( int w = first >> 6; w <= last >> 6; ++w )
+    {
+    uint64_t x = p[w];
+    if( w == first >> 6 ) x &= ~(uint64_t)0 << ( first & 63 );
+    if( w == last >> 6 ) x &= ~(uint64_t)0 >> ( 63 - ( last & 63 ) );
+    sum += count_bits( x );
+    }
+  return sum;
+  }
+
+
+// Every black component has at least a run in each of its rows, and its
+// first run has no black pixel above. So 'runs' bounds the sum of the
+// heights of the components and 'top_runs' bounds their number.
+void Bitplane::count_runs( long & runs, long & top_runs ) const
+  {
+  runs = top_runs = 0;
+  for( int row = top(); row <= bottom(); ++row )
+    for( int col = next_black( row, left() ); col <= right(); )
+      {
+      const int end = next_white( row, col ) - 1;
+      ++runs;
+      if( row == top() ||
+          black_pixels( row - 1, std::max( left(), col - 1 ),
+                        std::min( right(), end + 1 ) ) == 0 ) ++top_runs;
+      col = next_black( row, end + 1 );
+      }
+  }
+
+
+bool Bitplane::blank_row( const int row ) const
+  {
+  const uint64_t * const p = row_data( row );
+  for( int w = 0; w < words_; ++w ) if( p[w] ) return false;
+  return true;
+  }
+
+
+bool Bitplane::same_words( const Bitplane & b, const int first_row,
+                           const int last_row, const int first_word,
+                           const int last_word ) const
+  {
+  const int size = ( last_word - first_word + 1 ) * sizeof data[0];
+  for( int row = first_row; row <= last_row; ++row )
+    if( std::memcmp( row_data( row ) + first_word,
+                     b.row_data( row ) + first_word, size ) != 0 )
+      return false;
+  return true;
+  }
+
+
+// Returns the column of the first black pixel at or after 'col' in
+// 'row', or right() + 1 if there is none. Skips white words whole.
+int Bitplane::next_black( const int row, const int col ) const
+  {
+  const int i = col - left();
+  if( i >= width() ) return right() + 1;
+  const uint64_t * const p = row_data( row );
+  int w = i >> 6;
+  uint64_t x = p[w] & ( ~(uint64_t)0 << ( i & 63 ) );
+  while( !x ) { if( ++w >= words_ ) return right() + 1; x = p[w]; }
+  return left() + 64 * w + lowest_bit( x );
+  }
+
+
+// Returns the column of the first white pixel at or after 'col' in
+// 'row', or right() + 1 if there is none. Skips black words whole.
+int Bitplane::next_white( const int row, const int col ) const
+  {
+  const int i = col - left();
+  if( i >= width() ) return right() + 1;
+  const uint64_t * const p = row_data( row );
+  int w = i >> 6;
+  uint64_t x = ~p[w] & ( ~(uint64_t)0 << ( i & 63 ) );
+  while( !x ) { if( ++w >= words_ ) return right() + 1; x = ~p[w]; }
+  return std::min( right() + 1, left() + 64 * w + lowest_bit( x ) );
+  }
+
+
+// Sets 're' to the smallest rectangle containing all the black pixels.
+// Returns false if the image is blank.
+bool Bitplane::content_box( Rectangle & re ) const
+  {
+  int t = top(), b = bottom();
+  while( t <= b && blank_row( t ) ) ++t;
+  if( t > b ) return false;
+  while( blank_row( b ) ) --b;
+
+  std::vector< uint64_t > columns( words_, 0 );	// OR of all rows
+  for( int row = t; row <= b; ++row )
+    {
+    const uint64_t * const p = row_data( row );
+    for( int w = 0; w < words_; ++w ) columns[w] |= p[w];
+    }
+  int wl = 0, wr = words_ - 1;
+  while( !columns[wl] ) ++wl;
+  while( !columns[wr] ) --wr;
+  re = Rectangle( left() + 64 * wl + lowest_bit( columns[wl] ), t,
+                  left() + 64 * wr + highest_bit( columns[wr] ), b );
+  return true;
+  }
+
+
+// Sets to white all the pixels of the intersection of 're' and the
+// bitplane. Whole words are cleared at once.
+void Bitplane::clear_rectangle( const Rectangle & re )
+  {
+  const int l = std::max( left(), re.left() ) - left();
+  const int r = std::min( right(), re.right() ) - left();
+  if( l > r ) return;
+  const int wl = l >> 6, wr = r >> 6;
+  const uint64_t ml = ~(uint64_t)0 << ( l & 63 );
+  const uint64_t mr = ~(uint64_t)0 >> ( 63 - ( r & 63 ) );
+  for( int row = std::max( top(), re.top() );
+       row <= std::min( bottom(), re.bottom() ); ++row )
+    {
+    uint64_t * const p = row_data( row );
+    if( wl == wr ) { p[wl] &= ~( ml & mr ); continue; }
+    p[wl] &= ~ml;
+    for( int w = wl + 1; w < wr; ++w ) p[w] = 0;
+    p[wr] &= ~mr;
+    }
+  }
+
+
+// Removes the black pixels having no black neighbors. Works on whole
+// words; removing an isolated pixel does not change the neighborhood of
+// any other black pixel, so the removal can be done in place.
+// Returns the number of pixels removed.
+int Bitplane::remove_isolated_pixels()
+  {
+  const std::vector< uint64_t > blank( words_, 0 );
+  int removed = 0;
+  for( int row = top(); row <= bottom(); ++row )
+    {
+    uint64_t * const p = row_data( row );
+    const uint64_t * const up = ( row > top() ) ? row_data( row - 1 ) : &blank[0];
+    const uint64_t * const dn = ( row < bottom() ) ? row_data( row + 1 ) : &blank[0];
+    for( int w = 0; w < words_; ++w )
+      {
+      const uint64_t x = p[w];
+      if( !x ) continue;
+      // columns having a black pixel in row - 1, row or row + 1
+      const uint64_t v = up[w] | x | dn[w];
+      const uint64_t vl = ( w > 0 ) ? up[w-1] | p[w-1] | dn[w-1] : 0;
+      const uint64_t vr = ( w + 1 < words_ ) ? up[w+1] | p[w+1] | dn[w+1] : 0;
+      const uint64_t neighbors = up[w] | dn[w] |
+                                 ( v << 1 ) | ( vl >> 63 ) |
+                                 ( v >> 1 ) | ( vr << 63 );
+      const uint64_t isolated = x & ~neighbors;
+      if( isolated )
+        {
+        p[w] = x & ~isolated;
+        removed += count_bits( isolated );
+        }
+      }
+    }
+  return removed;
+  }
+
+
+// Removes the 8-connected black components of 'size' pixels or less.
+// Isolated pixels are removed first a word at a time. Then every black
+// pixel not yet filled seeds a flood fill which stops as soon as it
+// exceeds 'size' pixels or reaches a pixel of a component already known
+// to be larger. As every pixel is filled at most once, the cost is
+// linear in the number of black pixels.
+// Returns the number of pixels removed.
+int Bitplane::remove_speckles( const int size )
+  {
+  if( size <= 0 ) return 0;
+  int removed = remove_isolated_pixels();
+  if( size <= 1 ) return removed;
+
+  std::vector< uint64_t > seen( data.size(), 0 );	// filled pixels
+  std::vector< uint64_t > big( data.size(), 0 );	// in large components
+  std::vector< std::pair< int, int > > stack, fill;
+  for( int row = top(); row <= bottom(); ++row )
+    for( int col = next_black( row, left() ); col <= right();
+         col = next_black( row, col + 1 ) )
+      {
+      const int i = ( row - top() ) * words_ + ( ( col - left() ) >> 6 );
+      const uint64_t mask = (uint64_t)1 << ( ( col - left() ) & 63 );
+      if( seen[i] & mask ) continue;
+      seen[i] |= mask;
+      bool large = false;
+      stack.clear(); fill.clear();
+      stack.push_back( std::make_pair( row, col ) );
+      while( !stack.empty() && !large )
+        {
+        const int r = stack.back().first, c = stack.back().second;
+        stack.pop_back();
+        fill.push_back( std::make_pair( r, c ) );
+        if( (int)fill.size() > size ) { large = true; break; }
+        for( int nr = std::max( top(), r - 1 );
+             nr <= std::min( bottom(), r + 1 ) && !large; ++nr )
+          for( int nc = std::max( left(), c - 1 );
+               nc <= std::min( right(), c + 1 ); ++nc )
+            {
+            if( !get_bit( nr, nc ) ) continue;
+            const int j = ( nr - top() ) * words_ + ( ( nc - left() ) >> 6 );
+            const uint64_t m = (uint64_t)1 << ( ( nc - left() ) & 63 );
+            if( big[j] & m ) { large = true; break; }
+            if( !( seen[j] & m ) )
+              { seen[j] |= m; stack.push_back( std::make_pair( nr, nc ) ); }
+            }
+        }
+      if( large )			// mark every pixel seen by this fill
+        {
+        fill.insert( fill.end(), stack.begin(), stack.end() );
+        for( unsigned k = 0; k < fill.size(); ++k )
+          {
+          const int r = fill[k].first, c = fill[k].second;
+          big[( r - top() ) * words_ + ( ( c - left() ) >> 6 )] |=
+            (uint64_t)1 << ( ( c - left() ) & 63 );
+          }
+        continue;
+        }
+      for( unsigned k = 0; k < fill.size(); ++k )
+        set_bit( fill[k].first, fill[k].second, false );
+      removed += fill.size();
+      }
+  return removed;
+  }
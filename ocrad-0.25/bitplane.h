@@ -0,0 +1,76 @@
+/*  GNU Ocrad - Optical Character Recognition program
+    Copyright (C) 2003-2015 Antonio Diaz Diaz.
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 2 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+class Page_image;
+
+// Binarized image packed 64 pixels per word, 1 = black. Pixel 'col' of
+// a row is stored in bit ( col - left() ) % 64 of word
+// ( col - left() ) / 64. Padding bits at the end of each row are 0.
+//
+class Bitplane : public Rectangle
+  {
+  std::vector< uint64_t > data;
+  int words_;					// words per row
+
+  const uint64_t * row_data( const int row ) const
+    { return &data[( row - top() ) * words_]; }
+  uint64_t * row_data( const int row )
+    { return &data[( row - top() ) * words_]; }
+
+  void sauvola_band( const Page_image & page_image, const int window,
+                     const int first_row, const int last_row );
+  static void sauvola_job( void * const arg, const int i );
+
+public:
+  // Binarizes 'page_image' using 'threshold', or its own threshold if
+  // 'threshold' < 0. If 'window' > 0 and 'page_image' is not bilevel,
+  // uses instead a local threshold computed over a square of side
+  // 'window' around each pixel, with up to 'threads' threads.
+  explicit Bitplane( const Page_image & page_image, const int threshold = -1,
+                     const int window = 0, const int threads = 1 );
+
+  bool get_bit( const int row, const int col ) const
+    {
+    const int i = col - left();
+    return ( row_data( row )[i>>6] >> ( i & 63 ) ) & 1;
+    }
+  void set_bit( const int row, const int col, const bool bit )
+    {
+    const int i = col - left();
+    const uint64_t mask = (uint64_t)1 << ( i & 63 );
+    if( bit ) row_data( row )[i>>6] |= mask;
+    else row_data( row )[i>>6] &= ~mask;
+    }
+
+  int words() const { return words_; }
+  long long bytes() const { return data.size() * sizeof data[0]; }
+  long ink() const;				// number of black pixels
+  bool blank_row( const int row ) const;
+  int black_pixels( const int row, const int first_col, const int last_col ) const;
+  // counts the black runs, and those not 8-connected to the row above
+  void count_runs( long & runs, long & top_runs ) const;
+  // true if words 'first_word' to 'last_word' of rows 'first_row' to
+  // 'last_row' are equal in 'b', which must have the same position and size
+  bool same_words( const Bitplane & b, const int first_row, const int last_row,
+                   const int first_word, const int last_word ) const;
+  int next_black( const int row, const int col ) const;
+  int next_white( const int row, const int col ) const;
+  bool content_box( Rectangle & re ) const;
+  void clear_rectangle( const Rectangle & re );
+  int remove_isolated_pixels();
+  int remove_speckles( const int size );
+  };
@@ -28,41 +28,18 @@
 
 namespace {
 
-void delete_hole( std::vector< Bitmap * > & holep_vector,
-                  std::vector< Bitmap * > & v1,
-                  std::vector< Bitmap * > & v2,
-                  Bitmap * const p, int i )
+struct Run			// run of white pixels in a row
   {
-  std::replace( v1.begin() + i, v1.end(), p, (Bitmap *) 0 );
-  std::replace( v2.begin(), v2.begin() + i, p, (Bitmap *) 0 );
-
-  i = holep_vector.size();
-  while( --i >= 0 && holep_vector[i] != p ) ;
-  if( i < 0 ) Ocrad::internal_error( "delete_hole, lost hole." );
-  holep_vector.erase( holep_vector.begin() + i );
-  delete p;
-  }
+  int row, l, r;
+  Run( const int row_, const int l_, const int r_ )
+    : row( row_ ), l( l_ ), r( r_ ) {}
+  };
 
 
-inline void join_holes( std::vector< Bitmap * > & holep_vector,
-                        std::vector< Bitmap * > & v1,
-                        std::vector< Bitmap * > & v2,
-                        Bitmap * p1, Bitmap * p2, int i )
+int find_root( std::vector< int > & parent, int i )
   {
-  if( p1->top() > p2->top() )
-    {
-    Bitmap * const temp = p1; p1 = p2; p2 = temp;
-    std::replace( v2.begin(), v2.begin() + ( i + 1 ), p2, p1 );
-    }
-  else std::replace( v1.begin() + i, v1.end(), p2, p1 );
-
-  i = holep_vector.size();
-  while( --i >= 0 && holep_vector[i] != p2 ) ;
-  if( i < 0 ) Ocrad::internal_error( "join_holes, lost hole." );
-  holep_vector.erase( holep_vector.begin() + i );
-
-  p1->add_bitmap( *p2 );
-  delete p2;
+  while( parent[i] != i ) i = parent[i] = parent[parent[i]];
+  return i;
   }
 
 
@@ -81,7 +58,8 @@ void delete_outer_holes( const Rectangle & re,
 
 
 Blob::Blob( const Blob & b )
-  : Bitmap( b ), holepv( b.holepv )
+  : Bitmap( b ), holepv( b.holepv ), holes_pending( b.holes_pending ),
+    refs_( 0 )
   {
   for( unsigned i = 0; i < holepv.size(); ++i )
     holepv[i] = new Bitmap( *b.holepv[i] );
@@ -97,6 +75,7 @@ Blob & Blob::operator=( const Blob & b )
     holepv = b.holepv;
     for( unsigned i = 0; i < holepv.size(); ++i )
       holepv[i] = new Bitmap( *b.holepv[i] );
+    holes_pending = b.holes_pending;
     }
   return *this;
   }
@@ -220,83 +199,92 @@ void Blob::fill_hole( const int i )
   }
 
 
+// Deletes the current holes and marks the blob so that its holes are
+// found the first time they are used. Many blobs (dots, 'l', 'i') are
+// recognized without ever looking at their holes.
 void Blob::find_holes()
   {
   for( unsigned i = 0; i < holepv.size(); ++i ) delete holepv[i];
   holepv.clear();
-  if( height() < 3 || width() < 3 ) return;
+  holes_pending = true;
+  }
 
-  std::vector< Bitmap * > old_data( width(), (Bitmap *) 0 );
-  std::vector< Bitmap * > new_data( width(), (Bitmap *) 0 );
 
+// Finds the holes of the blob, which are the 4-connected components of
+// white pixels not touching the border. The runs of white pixels of each
+// row are joined with the overlapping runs of the row above, and the
+// holes are built directly from the runs of each component, in the order
+// of their first pixel. Small holes are ignored as noise.
+void Blob::label_holes() const
+  {
+  holes_pending = false;
+  if( height() < 3 || width() < 3 ) return;
+
+  std::vector< Run > runs;
+  std::vector< int > parent;
+  std::vector< uint8_t > outer;		// run touches the border
+  int prev_begin = 0, prev_end = 0;
   for( int row = top(); row <= bottom(); ++row )
     {
-    old_data.swap( new_data );
-    new_data[0] = get_bit( row, left() ) ? this : 0;
-    for( int col = left() + 1; col < right(); ++col )
+    const int begin = runs.size();
+    for( int col = left(); col <= right(); )
       {
-      const int dcol = col - left();
-      if( get_bit( row, col ) ) new_data[dcol] = this;	// black pixel
-      else						// white pixel
+      if( get_bit( row, col ) ) { ++col; continue; }
+      const int l = col;
+      while( col < right() && !get_bit( row, col + 1 ) ) ++col;
+      const Run run( row, l, col++ );
+      const int i = runs.size();
+      runs.push_back( run ); parent.push_back( i );
+      outer.push_back( row == top() || row == bottom() ||
+                       run.l == left() || run.r == right() );
+      // join with the 4-connected runs of the row above
+      while( prev_begin < prev_end && runs[prev_begin].r < run.l ) ++prev_begin;
+      for( int j = prev_begin; j < prev_end && runs[j].l <= run.r; ++j )
         {
-        Bitmap *p;
-        Bitmap *lp = new_data[dcol-1];
-        Bitmap *tp = old_data[dcol];
-        if( lp == 0 || tp == 0 )
-          {
-          p = 0;
-          if( lp && lp != this )
-            delete_hole( holepv, old_data, new_data, lp, dcol );
-          else if( tp && tp != this )
-            delete_hole( holepv, old_data, new_data, tp, dcol );
-          }
-        else if( lp != this ) { p = lp; p->add_point( row, col ); }
-        else if( tp != this ) { p = tp; p->add_point( row, col ); }
-        else
-          {
-          p = new Bitmap( col, row, col, row );
-          p->set_bit( row, col, true );
-          holepv.push_back( p );
-          }
-        new_data[dcol] = p;
-        if( p && lp != tp && lp != this && tp != this )
-          join_holes( holepv, old_data, new_data, lp, tp, dcol );
+        const int ri = find_root( parent, i ), rj = find_root( parent, j );
+        if( ri == rj ) continue;
+        const int root = std::min( ri, rj ), other = std::max( ri, rj );
+        parent[other] = root; outer[root] |= outer[other];
         }
       }
-    if( !get_bit( row, right() ) )
-      {
-      Bitmap *lp = new_data[width()-2];
-      if( lp && lp != this )
-        delete_hole( holepv, old_data, new_data, lp, width() - 1 );
-      }
+    prev_begin = begin; prev_end = runs.size();
     }
 
-  for( unsigned i = holepv.size(); i > 0; )	// FIXME noise holes removal
+  const int n = runs.size();
+  std::vector< Rectangle > boxes;
+  std::vector< int > index( n, -1 ), area;	// index of box of root
+  for( int i = 0; i < n; ++i )
     {
-    Bitmap & h = *holepv[--i];
-    if( this->strictly_includes( h ) &&
-        ( h.height() > 4 || h.width() > 4 ||
-          ( ( h.height() > 2 || h.width() > 2 ) && h.area() > 3 ) ) )
-      continue;
-    delete &h; holepv.erase( holepv.begin() + i );
+    const int r = find_root( parent, i );
+    if( outer[r] ) continue;
+    const Run & run = runs[i];
+    if( r == i )
+      {
+      index[i] = boxes.size();
+      boxes.push_back( Rectangle( run.l, run.row, run.r, run.row ) );
+      area.push_back( 0 );
+      }
+    const int k = index[r];
+    boxes[k].add_rectangle( Rectangle( run.l, run.row, run.r, run.row ) );
+    area[k] += run.r - run.l + 1;
     }
-/*
-  while( holepv.size() > 3 )
+  std::vector< int > hole_index( boxes.size(), -1 );
+  for( unsigned k = 0; k < boxes.size(); ++k )	// FIXME noise holes removal
     {
-    int smin = holepv[0]->size();
-    for( unsigned i = 1; i < holepv.size(); ++i )
-      if( holepv[i]->size() < smin ) smin = holepv[i]->size();
-    for( int i = holepv.size() - 1; i >= 0; --i )
-      if( holepv[i]->size() == smin ) holepv.erase( holepv.begin() + i );
+    const Rectangle & re = boxes[k];
+    if( re.height() > 4 || re.width() > 4 ||
+        ( ( re.height() > 2 || re.width() > 2 ) && area[k] > 3 ) )
+      {
+      hole_index[k] = holepv.size();
+      holepv.push_back( new Bitmap( re.left(), re.top(), re.right(), re.bottom() ) );
+      }
     }
-  for( unsigned i = holepv.size(); i > 0; )
+  for( int i = 0; i < n; ++i )
     {
-    Bitmap & h = *holepv[--i];
-    if( !this->strictly_includes( h ) )
-      { delete &h; holepv.erase( holepv.begin() + i ); }
-    if( 20 * h.height() < height() && 16 * h.width() < width() ) fill_hole( i );
-//    else if( h.height() < 2 && h.width() < 2 && h.area() < 2 )
-//      { delete &h; holepv.erase( holepv.begin() + i ); }
+    const int r = find_root( parent, i );
+    if( outer[r] || hole_index[index[r]] < 0 ) continue;
+    Bitmap & h = *holepv[hole_index[index[r]]];
+    for( int col = runs[i].l; col <= runs[i].r; ++col )
+      h.set_bit( runs[i].row, col, true );
     }
-*/
   }
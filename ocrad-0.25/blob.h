@@ -17,14 +17,18 @@
 
 class Blob : public Bitmap
   {
-  std::vector< Bitmap * > holepv;		// vector of holes
+  mutable std::vector< Bitmap * > holepv;	// vector of holes
+  mutable bool holes_pending;		// find_holes called, holes not found
+  int refs_;				// number of Characters holding it
+
+  void label_holes() const;
 
 public:
   Blob( const int l, const int t, const int r, const int b )
-    : Bitmap( l, t, r, b ) {}
+    : Bitmap( l, t, r, b ), holes_pending( false ), refs_( 0 ) {}
 
   Blob( const Bitmap & source, const Rectangle & re )
-    : Bitmap( source, re ) {}
+    : Bitmap( source, re ), holes_pending( false ), refs_( 0 ) {}
 
   Blob( const Blob & b );
   Blob & operator=( const Blob & b );
@@ -45,7 +49,8 @@ public:
   void width ( const int w ) { right( left() + w - 1 ); }
 
   const Bitmap & hole( const int i ) const;
-  int holes() const { return holepv.size(); }
+  int holes() const
+    { if( holes_pending ) label_holes(); return holepv.size(); }
   //  id = 1 for blob dots, negative for hole dots, 0 otherwise
   int id( const int row, const int col ) const;
 
@@ -55,6 +60,11 @@ public:
   bool test_Q() const;
   void print( FILE * const outfile ) const;
 
+  // reference counting, used by Character to share blobs between copies
+  void hold() { ++refs_; }
+  bool release() { return --refs_ <= 0; }	// true if not held anymore
+  bool shared() const { return refs_ > 1; }
+
   void fill_hole( const int i );
-  void find_holes();
+  void find_holes();		// holes are found the first time they are used
   };
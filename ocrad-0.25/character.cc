@@ -33,11 +33,15 @@
 #include "feats.h"
 
 
+Character::Character( const Character & c, const int i )
+  : Rectangle( c.blob( i ) ), blobpv( 1, c.blobpv[i] )
+  { blobpv[0]->hold(); }
+
+
 Character::Character( const Character & c )
   : Rectangle( c ), blobpv( c.blobpv ), gv( c.gv )
   {
-  for( unsigned i = 0; i < blobpv.size(); ++i )
-    blobpv[i] = new Blob( *c.blobpv[i] );
+  for( unsigned i = 0; i < blobpv.size(); ++i ) blobpv[i]->hold();
   }
 
 
@@ -46,10 +50,10 @@ Character & Character::operator=( const Character & c )
   if( this != &c )
     {
     Rectangle::operator=( c );
-    for( unsigned i = 0; i < blobpv.size(); ++i ) delete blobpv[i];
-    blobpv = c.blobpv;
+    for( unsigned i = 0; i < c.blobpv.size(); ++i ) c.blobpv[i]->hold();
     for( unsigned i = 0; i < blobpv.size(); ++i )
-      blobpv[i] = new Blob( *c.blobpv[i] );
+      if( blobpv[i]->release() ) delete blobpv[i];
+    blobpv = c.blobpv;
     gv = c.gv;
     }
   return *this;
@@ -58,7 +62,8 @@ Character & Character::operator=( const Character & c )
 
 Character::~Character()
   {
-  for( unsigned i = 0; i < blobpv.size(); ++i ) delete blobpv[i];
+  for( unsigned i = 0; i < blobpv.size(); ++i )
+    if( blobpv[i]->release() ) delete blobpv[i];
   }
 
 
@@ -80,15 +85,21 @@ const Blob & Character::blob( const int i ) const
   }
 
 
-Blob & Character::blob( const int i )
+Blob & Character::unshared_blob( const int i )
   {
   if( i < 0 || i >= blobs() )
-    Ocrad::internal_error( "blob, index out of bounds" );
+    Ocrad::internal_error( "unshared_blob, index out of bounds" );
+  if( blobpv[i]->shared() )
+    {
+    blobpv[i]->release();
+    blobpv[i] = new Blob( *blobpv[i] );
+    blobpv[i]->hold();
+    }
   return *blobpv[i];
   }
 
 
-Blob & Character::main_blob()
+const Blob & Character::main_blob() const
   {
   int imax = 0;
   for( int i = 1; i < blobs(); ++i )
@@ -100,6 +111,7 @@ Blob & Character::main_blob()
 
 void Character::shift_blobp( Blob * const p )
   {
+  p->hold();
   add_rectangle( *p );
   int i = blobs() - 1;
   for( ; i >= 0; --i )
@@ -187,7 +199,8 @@ bool Character::maybe_letter() const
 
 void Character::join( Character & c )
   {
-  for( int i = 0; i < c.blobs(); ++i ) shift_blobp( c.blobpv[i] );
+  for( int i = 0; i < c.blobs(); ++i )
+    { shift_blobp( c.blobpv[i] ); c.blobpv[i]->release(); }
   c.blobpv.clear();
   }
 
@@ -39,8 +39,14 @@ private:
   void recognize13( const Charset & charset, const Rectangle & charbox );
 
 public:
+  // The blobs of a Character are shared by its copies, and copied only
+  // before being modified. So trial recognitions on copies of a Character,
+  // or on some of its blobs, don't copy any pixels.
   explicit Character( Blob * const p )
-    : Rectangle( *p ), blobpv( 1, p ) {}
+    : Rectangle( *p ), blobpv( 1, p ) { p->hold(); }
+
+  // Creates a Character sharing blob 'i' of 'c'
+  Character( const Character & c, const int i );
 
   Character( const Rectangle & re, int code, int value )
     : Rectangle( re ), gv( 1, Guess( code, value ) ) {}
@@ -52,11 +58,13 @@ public:
 
   int area() const;
   const Blob & blob( const int i ) const;
-  Blob & blob( const int i );
+  Blob & unshared_blob( const int i );		// copies blob 'i' if shared
   int blobs() const { return blobpv.size(); }
-  Blob & main_blob();
+  const Blob & main_blob() const;
 
   void shift_blobp( Blob * const p );
+  void share_blob( const Character & c, const int i )
+    { shift_blobp( &const_cast< Blob & >( c.blob( i ) ) ); }
 
   void add_guess( const int code, const int value )
     { gv.push_back( Guess( code, value ) ); }
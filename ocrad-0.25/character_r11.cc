@@ -33,6 +33,12 @@
 
 
 // First attempt at recognition without relying on context.
+// The tests are not pruned by charset or filter. The tests producing
+// only codes of a charset are already skipped if it is not enabled, and
+// each test ends the search for a character when it accepts, so skipping
+// a test whose codes a filter would discard could let a later test
+// produce a different code. The filters also map letters to the nearest
+// digit or to upper case.
 //
 void Character::recognize1( const Charset & charset, const Rectangle & charbox )
   {
@@ -255,10 +261,10 @@ void Character::recognize111( const Charset & charset, const Rectangle & charbox
         {
         int row = h.top() - ( b.bottom() - h.bottom() ) - 1;
         if( row <= b.top() || row + 1 >= h.top() ) return;
-        Blob & b1 = const_cast< Blob & >( b );
-        Blob b2( b );
-        b1.bottom( row ); b2.top( row + 1 );
-        blobpv.push_back( new Blob( b2 ) );
+        Blob * const p = new Blob( b );
+        p->top( row + 1 );
+        unshared_blob( 0 ).bottom( row );
+        blobpv.push_back( p ); p->hold();
         }
       }
     }
@@ -84,7 +84,7 @@ void Character::recognize12( const Charset & charset, const Rectangle & charbox
           b1.includes_hcenter( b2 ) && 4 * b1.height() > 5 * b2.height() &&
           Ocrad::similar( b1.bottom()-b1.top(), b2.bottom()-b1.top(), 10 ) )
         {
-        Character c2( new Blob( b2 ) ); c2.recognize1( charset, charbox );
+        Character c2( *this, 1 ); c2.recognize1( charset, charbox );
         if( ( c2.maybe('l') || c2.maybe('|') ) &&
             set_merged_guess( 'f', b2.left() - 1, 'i', 0 ) ) return;
         }
@@ -115,7 +115,7 @@ void Character::recognize12( const Charset & charset, const Rectangle & charbox
         if( f2.bp.minima( b2.height() / 4 ) == 2 &&
             b2.top() > b1.bottom() && b2.hcenter() < b1.left() )
           {
-          Character c2( new Blob( b2 ) ); c2.recognize1( charset, charbox );
+          Character c2( *this, 1 ); c2.recognize1( charset, charbox );
           if( c2.maybe('n') )
             {
             if( code == '.' && ( b1.left() < b2.hcenter() || b1.right() > b2.right() ) )
@@ -190,7 +190,7 @@ void Character::recognize12( const Charset & charset, const Rectangle & charbox
         ( b1.holes() == 1 && b1.bottom() < b2.top() &&
           b2.top() - b1.bottom() < b1.height() ) )
       {
-      Character c( new Blob( b2 ) ); c.recognize1( charset, charbox );
+      Character c( *this, 1 ); c.recognize1( charset, charbox );
       if( c.guesses() )
         {
         int code = c.guess( 0 ).code;
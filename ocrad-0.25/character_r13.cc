@@ -40,7 +40,7 @@ void Character::recognize13( const Charset & charset, const Rectangle & charbox
   const Blob & b1 = blob( 0 );
   const Blob & b2 = blob( 1 );
   const Blob & b3 = blob( 2 );		// lower blob
-  Character c( new Blob( b3 ) );
+  Character c( *this, 2 );
   int code = 0;
 
   c.recognize1( charset, charbox );
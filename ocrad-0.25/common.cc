@@ -21,8 +21,10 @@
 #include <cstring>
 #include <string>
 #include <vector>
+#include <time.h>
 
 #include "common.h"
+#include "parallel.h"
 #include "user_filter.h"
 
 
@@ -97,6 +99,17 @@ bool Ocrad::similar( const int a, const int b,
   }
 
 
+long long Ocrad::nanoseconds()
+  {
+#if defined(CLOCK_MONOTONIC)
+  timespec ts;
+  if( clock_gettime( CLOCK_MONOTONIC, &ts ) == 0 )
+    return ts.tv_sec * 1000000000LL + ts.tv_nsec;
+#endif
+  return clock() * ( 1000000000LL / CLOCKS_PER_SEC );
+  }
+
+
 bool Charset::enable( const char * const name )
   {
   for( int i = 0; i < charsets; ++i )
@@ -159,11 +172,15 @@ void Transformation::show_error( const char * const program_name,
   }
 
 
-Control::~Control()
+Control::~Control() { clear_filters(); }
+
+
+void Control::clear_filters()
   {
   for( unsigned f = filters.size(); f > 0; --f )
     if( filters[f-1].user_filterp )
       delete filters[f-1].user_filterp;
+  filters.clear();
   }
 
 
@@ -210,3 +227,88 @@ bool Control::set_format( const char * const name )
   if( std::strcmp( name, "utf8" ) == 0 ) { utf8 = true; return true; }
   return false;
   }
+
+
+bool Control::set_threads( const int n )
+  {
+  if( n < 0 || n > max_threads ) return false;
+  threads = ( n > 0 ) ? n : std::min( Ocrad::processors(), (int)max_threads );
+  return true;
+  }
+
+
+bool Control::set_threads( const char * const arg )
+  {
+  char * tail;
+  const long n = std::strtol( arg, &tail, 0 );
+  if( tail == arg || *tail || n < 0 || n > max_threads ) return false;
+  return set_threads( (int)n );
+  }
+
+
+bool Control::set_despeckle( const int size )
+  {
+  if( size < 0 || size > max_despeckle ) return false;
+  despeckle = size;
+  return true;
+  }
+
+
+bool Control::set_despeckle( const char * const arg )
+  {
+  char * tail;
+  const long n = std::strtol( arg, &tail, 0 );
+  if( tail == arg || *tail || n < 0 || n > max_despeckle ) return false;
+  return set_despeckle( (int)n );
+  }
+
+
+bool Control::set_memory_limit( const int mib )
+  {
+  if( mib < 0 || mib > max_memory_limit ) return false;
+  memory_limit = mib;
+  return true;
+  }
+
+
+bool Control::set_memory_limit( const char * const arg )
+  {
+  char * tail;
+  const long n = std::strtol( arg, &tail, 0 );
+  if( tail == arg || *tail || n < 0 || n > max_memory_limit ) return false;
+  return set_memory_limit( (int)n );
+  }
+
+
+bool Control::set_quality( const int level )
+  {
+  if( level < fast || level > thorough ) return false;
+  quality = Quality( level );
+  return true;
+  }
+
+
+bool Control::set_quality( const char * const name )
+  {
+  if( std::strcmp( name, "fast" ) == 0 ) { quality = fast; return true; }
+  if( std::strcmp( name, "thorough" ) == 0 ) { quality = thorough; return true; }
+  return false;
+  }
+
+
+bool Control::set_window( const int size )
+  {
+  if( size < 0 || size > max_window ) return false;
+  window = size;
+  return true;
+  }
+
+
+bool Control::set_window( const char * const arg )
+  {
+  if( !arg[0] ) { window = default_window; return true; }
+  char * tail;
+  const long n = std::strtol( arg, &tail, 0 );
+  if( tail == arg || *tail || n < 0 || n > max_window ) return false;
+  return set_window( (int)n );
+  }
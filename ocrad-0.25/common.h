@@ -23,6 +23,7 @@ namespace Ocrad {
 void internal_error( const char * const msg );
 bool similar( const int a, const int b,
               const int percent_dif, const int abs_dif = 1 );
+long long nanoseconds();			// monotonic clock
 
 } // end namespace Ocrad
 
@@ -36,6 +37,7 @@ public:
 
   Charset() : charset_( 0 ) {}
   bool enable( const char * const name );
+  bool operator==( const Charset & c ) const { return charset_ == c.charset_; }
   bool enabled( const Value cset ) const;
   bool only( const Value cset ) const;
   void show_error( const char * const program_name,
@@ -79,20 +81,51 @@ struct Filter
 
 struct Control
   {
+  enum { max_threads = 1024, max_despeckle = 1000,
+         max_memory_limit = 1 << 20,		// MiB
+         default_window = 41, max_window = 1001 };	// adaptive threshold
+  enum Quality { fast, thorough };
   Charset charset;
   std::vector< Filter > filters;
   FILE * outfile, * exportfile;
   int debug_level;
+  int threads;				// worker threads, 1 = serial
+  int despeckle;			// max size of specks removed, 0 = none
+  Quality quality;			// which optional passes are run
+  int memory_limit;			// MiB per page, 0 = no limit
+  int window;				// adaptive threshold size, 0 = global
   char filetype;
+  bool coarse_layout;			// remove pictures and rules first
+  bool keep_unfiltered;			// keep results to filter them again
   bool utf8;
 
+private:
+  Control( const Control & );			// declared as private
+  void operator=( const Control & );		// declared as private
+
+public:
   Control()
     : outfile( stdout ), exportfile( 0 ),
-      debug_level( 0 ), filetype( '4' ), utf8( false ) {}
+      debug_level( 0 ), threads( 1 ), despeckle( 0 ),
+      quality( thorough ), memory_limit( 0 ), window( 0 ), filetype( '4' ),
+      coarse_layout( false ), keep_unfiltered( false ), utf8( false ) {}
   ~Control();
 
+  void clear_filters();
   bool add_filter( const char * const program_name, const char * const name );
   int add_user_filter( const char * const program_name,
                        const char * const file_name );
   bool set_format( const char * const name );
+  bool set_threads( const int n );		// 0 = all processors
+  bool set_threads( const char * const arg );
+  bool set_despeckle( const int size );		// 0 = no despeckle
+  bool set_despeckle( const char * const arg );
+  bool set_memory_limit( const int mib );	// 0 = no limit
+  bool set_memory_limit( const char * const arg );
+  long long memory_budget() const		// in bytes, 0 = no limit
+    { return memory_limit * 1048576LL; }
+  bool set_quality( const int level );
+  bool set_quality( const char * const name );
+  bool set_window( const int size );		// 0 = global threshold
+  bool set_window( const char * const arg );	// "" = default_window
   };
@@ -29,6 +29,7 @@
 #include "blob.h"
 #include "profile.h"
 #include "feats.h"
+#include "rule_stats.h"
 
 
 Features::Features( const Blob & b_ )
@@ -215,7 +216,7 @@ Csegment Features::v_segment( const int row, const int col ) const
   }
 
 
-int Features::test_misc( const Rectangle & charbox ) const
+int Features::rule_misc( const Rectangle & charbox ) const
   {
   if( bp.minima() == 1 )
     {
@@ -313,3 +314,115 @@ int Features::test_misc( const Rectangle & charbox ) const
 
   return 0;
   }
+
+
+int Features::test_235Esz( const Charset & charset ) const
+  {
+  const Rule_stats::Probe probe( Rule_stats::t235Esz );
+  return probe( rule_235Esz( charset ) );
+  }
+
+
+int Features::test_49ARegpq( const Rectangle & charbox ) const
+  {
+  const Rule_stats::Probe probe( Rule_stats::t49ARegpq );
+  return probe( rule_49ARegpq( charbox ) );
+  }
+
+
+int Features::test_4ADQao( const Charset & charset, const Rectangle & charbox ) const
+  {
+  const Rule_stats::Probe probe( Rule_stats::t4ADQao );
+  return probe( rule_4ADQao( charset, charbox ) );
+  }
+
+
+int Features::test_6abd( const Charset & charset ) const
+  {
+  const Rule_stats::Probe probe( Rule_stats::t6abd );
+  return probe( rule_6abd( charset ) );
+  }
+
+
+int Features::test_EFIJLlT( const Charset & charset, const Rectangle & charbox ) const
+  {
+  const Rule_stats::Probe probe( Rule_stats::tEFIJLlT );
+  return probe( rule_EFIJLlT( charset, charbox ) );
+  }
+
+
+int Features::test_c() const
+  {
+  const Rule_stats::Probe probe( Rule_stats::tc );
+  return probe( rule_c() );
+  }
+
+
+int Features::test_frst( const Rectangle & charbox ) const
+  {
+  const Rule_stats::Probe probe( Rule_stats::tfrst );
+  return probe( rule_frst( charbox ) );
+  }
+
+
+int Features::test_G() const
+  {
+  const Rule_stats::Probe probe( Rule_stats::tG );
+  return probe( rule_G() );
+  }
+
+
+int Features::test_HKMNUuvwYy( const Rectangle & charbox ) const
+  {
+  const Rule_stats::Probe probe( Rule_stats::tHKMNUuvwYy );
+  return probe( rule_HKMNUuvwYy( charbox ) );
+  }
+
+
+int Features::test_hknwx( const Rectangle & charbox ) const
+  {
+  const Rule_stats::Probe probe( Rule_stats::thknwx );
+  return probe( rule_hknwx( charbox ) );
+  }
+
+
+int Features::test_s_cedilla() const
+  {
+  const Rule_stats::Probe probe( Rule_stats::ts_cedilla );
+  return probe( rule_s_cedilla() );
+  }
+
+
+bool Features::test_comma() const
+  {
+  const Rule_stats::Probe probe( Rule_stats::tcomma );
+  return probe( rule_comma() );
+  }
+
+
+int Features::test_easy( const Rectangle & charbox ) const
+  {
+  const Rule_stats::Probe probe( Rule_stats::teasy );
+  return probe( rule_easy( charbox ) );
+  }
+
+
+int Features::test_line( const Rectangle & charbox ) const
+  {
+  const Rule_stats::Probe probe( Rule_stats::tline );
+  return probe( rule_line( charbox ) );
+  }
+
+
+int Features::test_solid( const Rectangle & charbox ) const
+  {
+  const Rule_stats::Probe probe( Rule_stats::tsolid );
+  return probe( rule_solid( charbox ) );
+  }
+
+
+int Features::test_misc( const Rectangle & charbox ) const
+  {
+  const Rule_stats::Probe probe( Rule_stats::tmisc );
+  return probe( rule_misc( charbox ) );
+  }
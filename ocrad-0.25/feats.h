@@ -28,6 +28,26 @@ class Features
   void row_scan_init() const;
   void col_scan_init() const;
 
+  // The tests proper. The public test_* functions call them, counting
+  // and timing the calls if Rule_stats is enabled.
+  int rule_235Esz( const Charset & charset ) const;
+  int rule_49ARegpq( const Rectangle & charbox ) const;
+  int rule_4ADQao( const Charset & charset, const Rectangle & charbox ) const;
+  int rule_6abd( const Charset & charset ) const;
+  int rule_EFIJLlT( const Charset & charset, const Rectangle & charbox ) const;
+  int rule_c() const;
+  int rule_frst( const Rectangle & charbox ) const;
+  int rule_G() const;
+  int rule_HKMNUuvwYy( const Rectangle & charbox ) const;
+  int rule_hknwx( const Rectangle & charbox ) const;
+  int rule_s_cedilla() const;
+
+  bool rule_comma() const;
+  int rule_easy( const Rectangle & charbox ) const;
+  int rule_line( const Rectangle & charbox ) const;
+  int rule_solid( const Rectangle & charbox ) const;
+  int rule_misc( const Rectangle & charbox ) const;
+
 public:
   mutable Profile lp, tp, rp, bp, hp, wp;
 
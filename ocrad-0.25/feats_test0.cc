@@ -34,7 +34,7 @@
 // Looks for three black sections in column hcenter()  n, then tests if
 // upper and lower gaps are open to the right or to the left
 //
-int Features::test_235Esz( const Charset & charset ) const
+int Features::rule_235Esz( const Charset & charset ) const
   {
   const int csize = 3;
   const int ucoff[csize] = { 0, -1, +1 };
@@ -156,7 +156,7 @@ int Features::test_235Esz( const Charset & charset ) const
   }
 
 
-int Features::test_EFIJLlT( const Charset & charset, const Rectangle & charbox ) const
+int Features::rule_EFIJLlT( const Charset & charset, const Rectangle & charbox ) const
   {
   if( tp.minima( b.height() / 4 ) != 1 || bp.minima( b.height() / 4 ) != 1 )
     return 0;
@@ -324,7 +324,7 @@ int Features::test_EFIJLlT( const Charset & charset, const Rectangle & charbox )
   }
 
 
-int Features::test_c() const
+int Features::rule_c() const
   {
   if( lp.isconvex() || lp.ispit() )
     {
@@ -354,7 +354,7 @@ int Features::test_c() const
   }
 
 
-int Features::test_frst( const Rectangle & charbox ) const
+int Features::rule_frst( const Rectangle & charbox ) const
   {
   if( bp.minima( b.height() / 4 ) != 1 || tp.minima( b.height() / 2 ) != 1 ||
       bp.minima( b.height() / 2 ) != 1 ) return 0;
@@ -469,7 +469,7 @@ int Features::test_frst( const Rectangle & charbox ) const
   }
 
 
-int Features::test_G() const
+int Features::rule_G() const
   {
   if( lp.isconvex() || lp.ispit() )
     {
@@ -508,7 +508,7 @@ int Features::test_G() const
 
 // Common feature: U-shaped top of character
 //
-int Features::test_HKMNUuvwYy( const Rectangle & charbox ) const
+int Features::rule_HKMNUuvwYy( const Rectangle & charbox ) const
   {
   if( tp.minima( b.height() / 5 ) == 2 && tp.minima( b.height() / 4 ) == 2 &&
       tp.minima( b.height() / 2 ) <= 3 && tp.isctip() )
@@ -637,7 +637,7 @@ int Features::test_HKMNUuvwYy( const Rectangle & charbox ) const
 // Looks for the nearest frontier in column hcenter(), then tests if
 // gap is open downwards (except for 'x')
 //
-int Features::test_hknwx( const Rectangle & charbox ) const
+int Features::rule_hknwx( const Rectangle & charbox ) const
   {
   const int m8 = tp.minima( b.height() / 8 );
 
@@ -687,7 +687,7 @@ int Features::test_hknwx( const Rectangle & charbox ) const
 // Looks for four black sections in column hcenter()  1, then tests if
 // upper gap is open to the right and lower gaps are open to the left
 //
-int Features::test_s_cedilla() const
+int Features::rule_s_cedilla() const
   {
   int urow2 = 0, urow3 = 0, urow4 = 0, col, black_section = 0;
 
@@ -717,7 +717,7 @@ int Features::test_s_cedilla() const
   }
 
 
-bool Features::test_comma() const
+bool Features::rule_comma() const
   {
   if( b.holes() || b.height() <= b.width() || b.height() > 3 * b.width() )
     return false;
@@ -739,7 +739,7 @@ bool Features::test_comma() const
   }
 
 
-int Features::test_easy( const Rectangle & charbox ) const
+int Features::rule_easy( const Rectangle & charbox ) const
   {
   int code = test_solid( charbox );
   if( code ) return code;
@@ -760,7 +760,7 @@ int Features::test_easy( const Rectangle & charbox ) const
 // Recognizes single line, non-rectangular characters without holes.
 // '/<>C[\^`c
 //
-int Features::test_line( const Rectangle & charbox ) const
+int Features::rule_line( const Rectangle & charbox ) const
   {
   const int vnoise = ( b.height() / 30 ) + 1;
   const int topmax = b.top() + vnoise;
@@ -849,7 +849,7 @@ int Features::test_line( const Rectangle & charbox ) const
   }
 
 
-int Features::test_solid( const Rectangle & charbox ) const
+int Features::rule_solid( const Rectangle & charbox ) const
   {
   if( b.holes() ) return 0;
 
@@ -34,7 +34,7 @@
 // Tests if the lower half of character is open to the left, to the right,
 // and/or to the bottom
 //
-int Features::test_49ARegpq( const Rectangle & charbox ) const
+int Features::rule_49ARegpq( const Rectangle & charbox ) const
   {
   const Bitmap & h = b.hole( 0 );
 
@@ -109,7 +109,7 @@ int Features::test_49ARegpq( const Rectangle & charbox ) const
   }
 
 
-int Features::test_4ADQao( const Charset & charset, const Rectangle & charbox ) const
+int Features::rule_4ADQao( const Charset & charset, const Rectangle & charbox ) const
   {
   const Bitmap & h = b.hole( 0 );
   int left_delta = h.left() - b.left(), right_delta = b.right() - h.right();
@@ -171,7 +171,7 @@ int Features::test_4ADQao( const Charset & charset, const Rectangle & charbox )
 // Tests if the upper half of character is open to the left, to the right,
 // and/or to the bottom
 //
-int Features::test_6abd( const Charset & charset ) const
+int Features::rule_6abd( const Charset & charset ) const
   {
   const Bitmap & h = b.hole( 0 );
 
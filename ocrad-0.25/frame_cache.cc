@@ -0,0 +1,134 @@
+/*  GNU Ocrad - Optical Character Recognition program
+    Copyright (C) 2003-2015 Antonio Diaz Diaz.
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 2 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include <algorithm>
+#include <cstdio>
+#include <vector>
+#include <stdint.h>
+
+#include "common.h"
+#include "rectangle.h"
+#include "track.h"
+#include "ucs.h"
+#include "bitmap.h"
+#include "blob.h"
+#include "bitplane.h"
+#include "character.h"
+#include "textline.h"
+#include "frame_cache.h"
+
+
+Frame_cache::~Frame_cache()
+  {
+  delete_entries( old_entries );
+  delete_entries( new_entries );
+  delete bitplane;
+  }
+
+
+void Frame_cache::delete_entries( std::vector< Entry > & entries )
+  {
+  for( unsigned i = 0; i < entries.size(); ++i ) delete entries[i].line;
+  entries.clear();
+  }
+
+
+// Returns true if all the tiles touched by 're' are unchanged.
+bool Frame_cache::clean( const Rectangle & re ) const
+  {
+  if( !bitplane || !bitplane->includes( re ) ) return false;
+  const int t1 = ( re.top() - bitplane->top() ) / tile_size;
+  const int t2 = ( re.bottom() - bitplane->top() ) / tile_size;
+  const int c1 = ( re.left() - bitplane->left() ) / tile_size;
+  const int c2 = ( re.right() - bitplane->left() ) / tile_size;
+  for( int t = t1; t <= t2; ++t )
+    for( int c = c1; c <= c2; ++c )
+      if( dirty[t*tile_cols+c] ) return false;
+  return true;
+  }
+
+
+void Frame_cache::new_frame( const Bitplane & b, const Control & control )
+  {
+  delete_entries( old_entries );
+  old_entries.swap( new_entries );
+  hint = 0; reused_lines_ = 0;
+  const bool same_size = bitplane && (const Rectangle &)*bitplane == b;
+  if( !same_size || !( charset == control.charset ) ||
+      quality != control.quality )
+    delete_entries( old_entries );
+  charset = control.charset; quality = control.quality;
+
+  const int tile_rows = ( b.height() + tile_size - 1 ) / tile_size;
+  tile_cols = b.words();
+  dirty.assign( tile_rows * tile_cols, true );
+  dirty_tiles_ = dirty.size();
+  if( same_size )
+    {
+    for( int t = 0; t < tile_rows; ++t )
+      {
+      const int first_row = b.top() + t * tile_size;
+      const int last_row = std::min( b.bottom(), first_row + tile_size - 1 );
+      for( int c = 0; c < tile_cols; ++c )
+        if( b.same_words( *bitplane, first_row, last_row, c, c ) )
+          { dirty[t*tile_cols+c] = false; --dirty_tiles_; }
+      }
+    *bitplane = b;
+    }
+  else { delete bitplane; bitplane = new Bitplane( b ); }
+  }
+
+
+bool Frame_cache::restore( Textline & line, Key & key )
+  {
+  key.clear();
+  if( line.characters() <= 0 ) return false;
+  key.reserve( line.characters() );
+  Rectangle box( line.character( 0 ) );
+  for( int i = 0; i < line.characters(); ++i )
+    {
+    key.push_back( line.character( i ) );
+    box.add_rectangle( key.back() );
+    }
+  if( old_entries.empty() || !clean( box ) ) return false;
+
+  const unsigned size = old_entries.size();
+  for( unsigned n = 0; n < size; ++n )
+    {
+    const unsigned i = ( hint + n ) % size;
+    if( old_entries[i].key != key ) continue;
+    line = *old_entries[i].line;
+    hint = i + 1; ++reused_lines_;
+    store( key, line );
+    return true;
+    }
+  return false;
+  }
+
+
+void Frame_cache::store( const Key & key, const Textline & line )
+  { new_entries.push_back( Entry( key, new Textline( line ) ) ); }
+
+
+void Frame_cache::clear()
+  {
+  delete_entries( old_entries );
+  delete_entries( new_entries );
+  delete bitplane; bitplane = 0;
+  dirty.clear(); tile_cols = 0;
+  dirty_tiles_ = 0; reused_lines_ = 0;
+  }
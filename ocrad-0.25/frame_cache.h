@@ -0,0 +1,80 @@
+/*  GNU Ocrad - Optical Character Recognition program
+    Copyright (C) 2003-2015 Antonio Diaz Diaz.
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 2 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+class Bitplane;
+class Textline;
+
+// Keeps the binarized image and the recognized text lines of the last
+// image of a sequence (the frames of a video, for example), so that the
+// lines of the next image lying on areas that did not change don't need
+// to be recognized again. The image is compared in tiles of
+// 'tile_size' x 'tile_size' pixels.
+//
+class Frame_cache
+  {
+public:
+  // boxes of the characters of a line before recognition
+  typedef std::vector< Rectangle > Key;
+
+private:
+  enum { tile_size = 64 };		// the width must be one bitplane word
+  struct Entry
+    {
+    Key key;
+    Textline * line;			// recognized line
+    Entry( const Key & k, Textline * const l ) : key( k ), line( l ) {}
+    };
+
+  Bitplane * bitplane;			// binarized last image
+  std::vector< bool > dirty;		// tiles changed since last image
+  int tile_cols;
+  Charset charset;			// recognition settings of the
+  int quality;				// entries
+  std::vector< Entry > old_entries;	// lines of the last image
+  std::vector< Entry > new_entries;	// lines of the current image
+  unsigned hint;			// where to start the next search
+  int dirty_tiles_, reused_lines_;
+
+  Frame_cache( const Frame_cache & );		// declared as private
+  void operator=( const Frame_cache & );	// declared as private
+
+  void delete_entries( std::vector< Entry > & entries );
+  bool clean( const Rectangle & re ) const;
+
+public:
+  Frame_cache()
+    : bitplane( 0 ), tile_cols( 0 ), quality( -1 ), hint( 0 ),
+      dirty_tiles_( 0 ), reused_lines_( 0 ) {}
+  ~Frame_cache();
+
+  // Starts a new image, marking the tiles in which it differs from the
+  // last one. The lines of the last image are forgotten if its size or
+  // the recognition settings of 'control' have changed.
+  void new_frame( const Bitplane & b, const Control & control );
+
+  // If a line with the same character boxes as 'line' was recognized in
+  // the last image on tiles that did not change, replaces 'line' with
+  // its result and returns true. Else sets 'key' for 'store'.
+  bool restore( Textline & line, Key & key );
+  void store( const Key & key, const Textline & line );	// recognized line
+  void clear();
+
+  int tiles() const { return dirty.size(); }
+  int dirty_tiles() const { return dirty_tiles_; }
+  int lines() const { return new_entries.size(); }
+  int reused_lines() const { return reused_lines_; }
+  };
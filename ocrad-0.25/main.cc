@@ -22,6 +22,7 @@
 */
 
 #include <cctype>
+#include <cerrno>
 #include <climits>
 #include <cstdio>
 #include <cstdlib>
@@ -37,11 +38,16 @@
 
 #include "arg_parser.h"
 #include "common.h"
+#include "parallel.h"
 #include "rational.h"
 #include "rectangle.h"
+#include "rule_stats.h"
 #include "user_filter.h"
+#include "frame_cache.h"
 #include "page_image.h"
 #include "textpage.h"
+#include "result_cache.h"
+#include "trace.h"
 
 
 namespace {
@@ -56,14 +62,21 @@ struct Input_control
   Transformation transformation;
   int scale;
   Rational threshold, ltwh[4];
-  bool copy, cut, invert, layout;
+  std::vector< Rational > sweep;	// thresholds to try, -1 = auto
+  const char * cache_dir;		// directory of the result cache
+  int cache_size;			// MiB
+  bool auto_scale, copy, cut, incremental, invert, layout, page_delimiters;
 
   Input_control()
-    : scale( 0 ), threshold( -1 ),
-      copy( false ), cut( false ), invert( false ), layout( false ) {}
+    : scale( 0 ), threshold( -1 ), cache_dir( 0 ),
+      cache_size( Result_cache::default_size ), auto_scale( false ),
+      copy( false ), cut( false ), incremental( false ), invert( false ),
+      layout( false ), page_delimiters( false ) {}
 
   bool parse_cut_rectangle( const char * const s );
   bool parse_threshold( const char * const s );
+  bool parse_sweep( const char * const s );
+  bool parse_cache_size( const char * const s );
   };
 
 
@@ -118,6 +131,39 @@ bool Input_control::parse_threshold( const char * const s )
   }
 
 
+bool Input_control::parse_sweep( const char * const s )
+  {
+  sweep.clear();
+  for( int i = 0; ; ++i )
+    {
+    Rational tmp;
+    int c;
+    if( std::strncmp( &s[i], "auto", 4 ) == 0 ) { tmp = -1; c = 4; }
+    else
+      {
+      c = tmp.parse( &s[i] );
+      if( !c || tmp < 0 || tmp > 1 ) break;
+      }
+    sweep.push_back( tmp ); i += c;
+    if( s[i] == 0 ) return true;
+    if( s[i] != ',' ) break;
+    }
+  show_error( "invalid threshold list.", 0, true );
+  return false;
+  }
+
+
+bool Input_control::parse_cache_size( const char * const s )
+  {
+  char * tail;
+  const long n = std::strtol( s, &tail, 0 );
+  if( tail == s || *tail || n < 0 || n > Result_cache::max_size )
+    { show_error( "bad cache size.", 0, true ); return false; }
+  cache_size = n;
+  return true;
+  }
+
+
 void show_help()
   {
   std::printf( "GNU Ocrad is an OCR (Optical Character Recognition) program based on a\n"
@@ -135,19 +181,31 @@ void show_help()
   std::printf( "\nOptions:\n"
                "  -h, --help                display this help and exit\n"
                "  -V, --version             output version information and exit\n"
+               "      --adaptive[=<n>]      threshold each pixel over a window of <n> pixels\n"
                "  -a, --append              append text to output file\n"
+               "      --cache=<dir>         reuse the results stored in <dir>\n"
+               "      --cache-size=<n>      max MiB of results stored in the cache [256]\n"
                "  -c, --charset=<name>      try '--charset=help' for a list of names\n"
+               "      --coarse-layout       skip pictures and rules found on a reduced image\n"
+               "      --despeckle=<n>       remove specks of up to <n> pixels before labeling\n"
                "  -e, --filter=<name>       try '--filter=help' for a list of names\n"
                "  -E, --user-filter=<file>  user-defined filter, see manual for format\n"
                "  -f, --force               force overwrite of output file\n"
                "  -F, --format=<fmt>        output format (byte, utf8)\n"
+               "      --incremental         recognize only what changed since the last image\n"
                "  -i, --invert              invert image levels (white on black)\n"
                "  -l, --layout              perform layout analysis\n"
+               "      --memory-limit=<n>    max MiB used per page, reduce image to fit\n"
+               "  -n, --threads=<n>         number of threads to use (0 = all processors)\n"
                "  -o, --output=<file>       place the output into <file>\n"
+               "  -p, --page-delimiters     mark the start of each image in the output\n"
+               "      --quality=<level>     recognition effort (fast, thorough)\n"
                "  -q, --quiet               suppress all messages\n"
-               "  -s, --scale=[-]<n>        scale input image by [1/]<n>\n"
+               "  -s, --scale=[-]<n>|auto   scale input image by [1/]<n> or to fit text\n"
+               "      --trace=<file>        write a trace of the recognition stages to <file>\n"
                "  -t, --transform=<name>    try '--transform=help' for a list of names\n"
                "  -T, --threshold=<n%%>      threshold for binarization (0-100%%)\n"
+               "      --threshold-sweep=<list>  recognize at each threshold, keep the best\n"
                "  -u, --cut=<l,t,w,h>       cut input image by given rectangle\n"
                "  -v, --verbose             be verbose\n"
                "  -x, --export=<file>       export results in ORF format to <file>\n" );
@@ -155,7 +213,8 @@ void show_help()
     {
     std::printf( "  -1..6                    pnm output file type (debug)\n"
                  "  -C, --copy               'copy' input to output (debug)\n"
-                 "  -D, --debug=<level>      (0-100) output intermediate data (debug)\n" );
+                 "  -D, --debug=<level>      (0-100) output intermediate data (debug)\n"
+                 "      --rule-stats         count and time the recognition tests (debug)\n" );
     }
   std::printf( "\nIf no files are specified, ocrad reads the image from standard input.\n"
                "If the -o option is not specified, ocrad sends text to standard output.\n"
@@ -187,16 +246,61 @@ const char * my_basename( const char * filename )
   }
 
 
-int process_file( FILE * const infile, const char * const infile_name,
-                  const Input_control & input_control,
-                  const Control & control )
+void print_results( const Textpage & textpage, const Control & control )
   {
-  if( verbosity >= 1 )
-    std::fprintf( stderr, "processing file '%s'\n", infile_name );
-  try
+  if( control.outfile )
+    { textpage.print( control ); std::fflush( control.outfile ); }
+  if( control.exportfile )
+    { textpage.xprint( control ); std::fflush( control.exportfile ); }
+  }
+
+
+// Recognizes 'page_image' at every threshold of 'input_control.sweep'
+// and prints the results with the highest score.
+int sweep_page( const Page_image & page_image, const char * const infile_name,
+                const Input_control & input_control, const Control & control )
+  {
+  std::vector< int > thresholds;
+  for( unsigned i = 0; i < input_control.sweep.size(); ++i )
+    thresholds.push_back( page_image.threshold_level( input_control.sweep[i] ) );
+  std::vector< Textpage * > textpages;
+  Textpage::sweep( page_image, my_basename( infile_name ), control,
+                   input_control.layout, thresholds, textpages );
+  int best = -1;
+  for( unsigned i = 0; i < textpages.size(); ++i )
+    {
+    if( !textpages[i] ) continue;
+    if( verbosity >= 1 )
+      std::fprintf( stderr, "threshold %d: score %d\n",
+                    thresholds[i], textpages[i]->score() );
+    if( best < 0 || textpages[i]->score() > textpages[best]->score() )
+      best = i;
+    }
+  if( best >= 0 )
     {
-    Page_image page_image( infile, input_control.invert );
+    if( verbosity >= 1 )
+      std::fprintf( stderr, "best threshold = %d\n", thresholds[best] );
+    print_results( *textpages[best], control );
+    }
+  for( unsigned i = 0; i < textpages.size(); ++i ) delete textpages[i];
+  if( best < 0 ) { show_error( "not enough memory." ); return 1; }
+  return 0;
+  }
+
 
+int process_page( Page_image & page_image, const char * const infile_name,
+                  const int page, const Input_control & input_control,
+                  const Control & control, Frame_cache * const cache )
+  {
+  if( input_control.page_delimiters && !input_control.copy &&
+      control.debug_level == 0 )
+    {
+    if( page > 1 && control.outfile ) std::fputc( '\f', control.outfile );
+    if( control.exportfile )
+      std::fprintf( control.exportfile, "page %d\n", page );
+    }
+  try
+    {
     if( input_control.cut )
       {
       if( page_image.cut( input_control.ltwh ) )
@@ -211,10 +315,15 @@ int process_file( FILE * const infile, const char * const infile_name,
           std::fprintf( stderr, "file '%s' totally cut away\n", infile_name );
         return 1;
         }
-      }
+      page_image.transform( input_control.transformation );
+      }		// else the transformation was applied on load
 
-    page_image.transform( input_control.transformation );
     page_image.change_scale( input_control.scale );
+    if( input_control.auto_scale )
+      {
+      page_image.threshold( input_control.threshold );
+      page_image.change_scale( Textpage::auto_scale( page_image, control ) );
+      }
     page_image.threshold( input_control.threshold );
     if( verbosity >= 1 )
       {
@@ -226,23 +335,138 @@ int process_file( FILE * const infile, const char * const infile_name,
 
     if( input_control.copy )
       {
-      if( control.outfile ) page_image.save( control.outfile, control.filetype );
+      if( control.outfile )
+        {
+        page_image.save( control.outfile, control.filetype );
+        std::fflush( control.outfile );
+        }
       return 0;
       }
 
-    Textpage textpage( page_image, my_basename( infile_name ), control,
-                       input_control.layout );
-    if( control.debug_level == 0 )
+    if( !Textpage::fit_memory( page_image, control ) )
+      { show_error( "image too big for the memory limit." ); return 1; }
+    if( !input_control.sweep.empty() && control.debug_level == 0 )
       {
-      if( control.outfile ) textpage.print( control );
-      if( control.exportfile ) textpage.xprint( control );
+      const int retval =
+        sweep_page( page_image, infile_name, input_control, control );
+      if( verbosity >= 1 ) std::fputs( "\n", stderr );
+      return retval;
+      }
+    const Result_cache result_cache( input_control.cache_dir ?
+                                     input_control.cache_dir : "",
+                                     input_control.cache_size * 1048576LL );
+    std::string key;
+    if( input_control.cache_dir && control.debug_level == 0 )
+      {
+      const Trace::Span span( "cache_find" );
+      key = Result_cache::key( page_image, page_image.threshold(), control,
+                               input_control.layout );
+      const Textpage * const cached =
+        result_cache.find( key, my_basename( infile_name ) );
+      if( verbosity >= 1 )
+        std::fprintf( stderr, "result cache %s for key %s\n",
+                      cached ? "hit" : "miss", key.c_str() );
+      if( cached )
+        {
+        print_results( *cached, control ); delete cached;
+        if( verbosity >= 1 ) std::fputs( "\n", stderr );
+        return 0;
+        }
       }
+    Textpage textpage( page_image, my_basename( infile_name ), control,
+                       input_control.layout, -1, cache );
+    if( control.debug_level == 0 ) print_results( textpage, control );
+    if( !key.empty() && !result_cache.store( key, textpage ) )
+      show_error( "warning: can't store results in cache", errno );
     }
   catch( Page_image::Error e ) { show_error( e.msg ); return 2; }
+  catch( std::bad_alloc ) { show_error( "not enough memory." ); return 1; }
+  catch( ... )
+    { show_error( "internal error: unexpected exception." ); return 3; }
   if( verbosity >= 1 ) std::fputs( "\n", stderr );
   return 0;
   }
 
+
+struct Stream_state
+  {
+  FILE * const infile;
+  const char * const infile_name;
+  const Input_control & input_control;
+  const Control & control;
+  Page_image * current;		// image being recognized
+  Page_image * next;		// image being decoded
+  const char * error;		// error found decoding 'next'
+  Frame_cache cache;		// results of the last image, if incremental
+  int page;			// number of 'current' in the stream
+  int retval;			// status of 'current'
+
+  Stream_state( FILE * const f, const char * const name,
+                const Input_control & ic, const Control & c )
+    : infile( f ), infile_name( name ), input_control( ic ), control( c ),
+      current( 0 ), next( 0 ), error( 0 ), page( 0 ), retval( 0 ) {}
+  };
+
+
+void decode_next( Stream_state & st )
+  {
+  try
+    {
+    if( st.page == 0 || Page_image::more_images( st.infile ) )
+      {
+      const Trace::Span span( "decode" );
+      // the image must be cut before being transformed
+      const Input_control & ic = st.input_control;
+      st.next = new Page_image( st.infile, ic.invert,
+                                st.control.memory_budget(),
+                                ic.cut ? Transformation() : ic.transformation );
+      }
+    }
+  catch( Page_image::Error e ) { st.error = e.msg; }
+  catch( std::bad_alloc ) { st.error = "not enough memory."; }
+  }
+
+
+// process_page and decode_next catch everything; exceptions can't
+// leave a job.
+void page_job( void * const arg, const int i )
+  {
+  Stream_state & st = *(Stream_state *)arg;
+  if( i == 0 )
+    st.retval = process_page( *st.current, st.infile_name, st.page,
+                              st.input_control, st.control,
+                              st.input_control.incremental ? &st.cache : 0 );
+  else decode_next( st );
+  }
+
+
+// Recognizes every image in 'infile'. The next image is decoded while
+// the current one is being recognized.
+//
+int process_file( FILE * const infile, const char * const infile_name,
+                  const Input_control & input_control,
+                  const Control & control )
+  {
+  if( verbosity >= 1 )
+    std::fprintf( stderr, "processing file '%s'\n", infile_name );
+  // decode serially if verbose to keep the messages in order
+  const int threads = ( verbosity < 1 ) ? 2 : 1;
+  Stream_state st( infile, infile_name, input_control, control );
+  int retval = 0;
+
+  decode_next( st );
+  while( st.next )
+    {
+    st.current = st.next; st.next = 0; ++st.page;
+    Ocrad::parallel_run( page_job, &st, 2, threads );
+    delete st.current; st.current = 0;
+    if( st.retval > retval ) retval = st.retval;
+    if( st.retval > 1 ) { delete st.next; st.next = 0; st.error = 0; }
+    }
+  if( st.error ) { show_error( st.error ); retval = 2; }
+  return retval;
+  }
+
 } // end namespace
 
 
@@ -260,6 +484,9 @@ int main( const int argc, const char * const argv[] )
   bool append = false, force = false;
   invocation_name = argv[0];
 
+  enum { opt_adaptive = 256, opt_cache, opt_cache_size, opt_despeckle,
+         opt_coarse, opt_incremental, opt_memory, opt_quality, opt_rule_stats,
+         opt_sweep, opt_trace };
   const Arg_parser::Option options[] =
     {
     { '1', 0,             Arg_parser::no  },
@@ -279,7 +506,9 @@ int main( const int argc, const char * const argv[] )
     { 'h', "help",        Arg_parser::no  },
     { 'i', "invert",      Arg_parser::no  },
     { 'l', "layout",      Arg_parser::no  },
+    { 'n', "threads",     Arg_parser::yes },
     { 'o', "output",      Arg_parser::yes },
+    { 'p', "page-delimiters", Arg_parser::no },
     { 'q', "quiet",       Arg_parser::no  },
     { 's', "scale",       Arg_parser::yes },
     { 't', "transform",   Arg_parser::yes },
@@ -288,6 +517,17 @@ int main( const int argc, const char * const argv[] )
     { 'v', "verbose",     Arg_parser::no  },
     { 'V', "version",     Arg_parser::no  },
     { 'x', "export",      Arg_parser::yes },
+    { opt_adaptive, "adaptive", Arg_parser::maybe },
+    { opt_cache, "cache", Arg_parser::yes },
+    { opt_cache_size, "cache-size", Arg_parser::yes },
+    { opt_despeckle, "despeckle", Arg_parser::yes },
+    { opt_coarse, "coarse-layout", Arg_parser::no },
+    { opt_incremental, "incremental", Arg_parser::no },
+    { opt_memory, "memory-limit", Arg_parser::yes },
+    { opt_quality, "quality", Arg_parser::yes },
+    { opt_rule_stats, "rule-stats", Arg_parser::no },
+    { opt_sweep, "threshold-sweep", Arg_parser::yes },
+    { opt_trace, "trace", Arg_parser::yes },
     {  0 , 0,             Arg_parser::no  } };
 
   const Arg_parser parser( argc, argv, options );
@@ -327,9 +567,16 @@ int main( const int argc, const char * const argv[] )
       case 'h': show_help(); return 0;
       case 'i': input_control.invert = true; break;
       case 'l': input_control.layout = true; break;
+      case 'n': if( !control.set_threads( arg ) )
+                  { show_error( "bad number of threads.", 0, true ); return 1; }
+                break;
       case 'o': outfile_name = arg; break;
+      case 'p': input_control.page_delimiters = true; break;
       case 'q': verbosity = -1; break;
-      case 's': input_control.scale = std::strtol( arg, 0, 0 ); break;
+      case 's': if( std::strcmp( arg, "auto" ) == 0 )
+                  input_control.auto_scale = true;
+                else input_control.scale = std::strtol( arg, 0, 0 );
+                break;
       case 't': if( !input_control.transformation.set( arg ) )
                   { input_control.transformation.show_error( program_name, arg );
                   return 1; }
@@ -339,6 +586,32 @@ int main( const int argc, const char * const argv[] )
       case 'v': if( verbosity < 4 ) ++verbosity; break;
       case 'V': show_version(); return 0;
       case 'x': exportfile_name = arg; break;
+      case opt_adaptive: if( !control.set_window( arg ) )
+                  { show_error( "bad window size.", 0, true ); return 1; }
+                break;
+      case opt_cache: input_control.cache_dir = arg; break;
+      case opt_cache_size: if( !input_control.parse_cache_size( arg ) ) return 1;
+                break;
+      case opt_despeckle: if( !control.set_despeckle( arg ) )
+                  { show_error( "bad speck size.", 0, true ); return 1; }
+                break;
+      case opt_coarse: control.coarse_layout = true; break;
+      case opt_incremental: input_control.incremental = true; break;
+      case opt_memory: if( !control.set_memory_limit( arg ) )
+                  { show_error( "bad memory limit.", 0, true ); return 1; }
+                break;
+      case opt_quality: if( !control.set_quality( arg ) )
+                  { show_error( "bad quality level.", 0, true ); return 1; }
+                break;
+      case opt_rule_stats: Rule_stats::enabled = true; break;
+      case opt_sweep: if( !input_control.parse_sweep( arg ) ) return 1; break;
+      case opt_trace: if( !Trace::open( arg ) )
+                  {
+                  if( verbosity >= 0 )
+                    std::fprintf( stderr, "Can't open '%s'\n", arg );
+                  return 1;
+                  }
+                break;
       default : Ocrad::internal_error( "uncaught option." );
       }
     } // end process options
@@ -405,21 +678,11 @@ int main( const int argc, const char * const argv[] )
     if( !infile ) break;
 
     const int tmp = process_file( infile, infile_name, input_control, control );
-    if( infile == stdin )
-      {
-      if( tmp <= 1 )		// detect EOF
-        {
-        int ch;
-        do ch = std::fgetc( infile ); while( ch == 0 || std::isspace( ch ) );
-        std::ungetc( ch, infile );
-        }
-      if( tmp > 1 || std::feof( infile ) || std::ferror( infile ) ) infile = 0;
-      }
+    if( infile == stdin ) infile = 0;
     if( tmp > retval ) retval = tmp;
-    if( control.outfile ) std::fflush( control.outfile );
-    if( control.exportfile ) std::fflush( control.exportfile );
     }
   if( control.outfile ) std::fclose( control.outfile );
   if( control.exportfile ) std::fclose( control.exportfile );
+  if( Rule_stats::enabled ) Rule_stats::print( stderr );
   return retval;
   }
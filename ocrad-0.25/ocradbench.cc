@@ -0,0 +1,307 @@
+/*  Ocradbench - Microbenchmarks for the glyph-level kernels of Ocrad
+    Copyright (C) 2009-2015 Antonio Diaz Diaz.
+
+    This program is free software: you have unlimited permission
+    to copy, distribute and modify it.
+
+    Usage is:
+      ocradbench filename.pnm...
+
+    This program recognizes the specified image files, and the same
+    images scaled by 2, and runs each kernel over the blobs of all the
+    characters found. For each kernel it prints the mean time per glyph
+    and its standard deviation over several runs. Then it prints the
+    time taken to recognize the page at each quality level and the
+    number of characters whose best guess differs from the 'thorough'
+    result. The quality levels are also compared on the images reduced
+    by 2, where more characters are left unrecognized by the first pass.
+*/
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+#include <vector>
+#include <stdint.h>
+
+#include "common.h"
+#include "rectangle.h"
+#include "segment.h"
+#include "ucs.h"
+#include "track.h"
+#include "bitmap.h"
+#include "blob.h"
+#include "character.h"
+#include "profile.h"
+#include "feats.h"
+#include "page_image.h"
+#include "textline.h"
+#include "textblock.h"
+#include "textpage.h"
+
+
+namespace {
+
+const int runs = 9;			// timed runs of each kernel
+const long long min_run_time = 20000000;	// 20 ms
+
+// Each kernel processes blob 'b' ('next' is the following glyph) and
+// returns a value depending on the result, so that it can't be
+// optimized away.
+typedef long (* Kernel)( const Blob & b, const Blob & next );
+
+
+long blob_copy( const Blob & b, const Blob & )
+  { const Blob copy( b ); return copy.size(); }
+
+
+long profile_init( const Blob & b, const Blob & )
+  {
+  long sum = 0;
+  for( int t = Profile::left; t <= Profile::width; ++t )
+    { Profile p( b, Profile::Type( t ) ); sum += p.samples(); }
+  return sum;
+  }
+
+
+long profile_shape( const Blob & b, const Blob & )
+  {
+  long sum = 0;
+  for( int t = Profile::left; t <= Profile::bottom; ++t )
+    {
+    Profile p( b, Profile::Type( t ) );
+    sum += p.isconvex() + 2 * p.ispit() + 4 * p.istip();
+    }
+  return sum;
+  }
+
+
+long features_bars( const Blob & b, const Blob & )
+  { const Features f( b ); return f.hbars() + f.vbars(); }
+
+
+long find_holes( const Blob & b, const Blob & )
+  { Blob copy( b ); copy.find_holes(); return copy.holes(); }
+
+
+long add_bitmap( const Blob & b, const Blob & next )
+  { Bitmap bm( b ); bm.add_bitmap( next ); return bm.size(); }
+
+
+long blob_id( const Blob & b, const Blob & )
+  {
+  long sum = 0;
+  for( int row = b.top(); row <= b.bottom(); ++row )
+    for( int col = b.left(); col <= b.right(); ++col )
+      sum += b.id( row, col );
+  return sum;
+  }
+
+
+struct K_entry
+  {
+  const char * const name;
+  Kernel kernel;
+  };
+
+const K_entry K_table[] =
+  {
+  { "Blob copy",            blob_copy },
+  { "Profile initialize",   profile_init },
+  { "Profile shape tests",  profile_shape },
+  { "Features hbars/vbars", features_bars },
+  { "Blob find_holes",      find_holes },
+  { "Bitmap add_bitmap",    add_bitmap },
+  { "Blob id",              blob_id },
+  { 0, 0 }
+  };
+
+
+long run_kernel( const Kernel kernel, const std::vector< const Blob * > & glyphs,
+                 const int loops )
+  {
+  long sink = 0;
+  const int size = glyphs.size();
+  for( int l = 0; l < loops; ++l )
+    for( int i = 0; i < size; ++i )
+      sink += kernel( *glyphs[i], *glyphs[( i + 1 ) % size] );
+  return sink;
+  }
+
+
+// Prints mean and standard deviation in ns per glyph of 'kernel'.
+long bench( const K_entry & entry, const std::vector< const Blob * > & glyphs )
+  {
+  long long t = Ocrad::nanoseconds();		// calibrate
+  long sink = run_kernel( entry.kernel, glyphs, 1 );
+  t = std::max( 1LL, Ocrad::nanoseconds() - t );
+  const int loops = std::max( 1LL, min_run_time / t );
+
+  double sum = 0, sum2 = 0;
+  for( int r = 0; r < runs; ++r )
+    {
+    const long long start = Ocrad::nanoseconds();
+    sink += run_kernel( entry.kernel, glyphs, loops );
+    const double ns = double( Ocrad::nanoseconds() - start ) /
+                      ( double( loops ) * glyphs.size() );
+    sum += ns; sum2 += ns * ns;
+    }
+  const double mean = sum / runs;
+  const double dev = std::sqrt( std::max( 0.0, sum2 / runs - mean * mean ) );
+  std::printf( "  %-22s %10.1f ns/glyph  +- %5.1f%%\n",
+               entry.name, mean, ( mean > 0 ) ? 100 * dev / mean : 0.0 );
+  return sink;
+  }
+
+
+// Returns the blobs of all the characters of 'textpage'.
+void collect_glyphs( const Textpage & textpage,
+                     std::vector< const Blob * > & glyphs )
+  {
+  for( int b = 0; b < textpage.textblocks(); ++b )
+    {
+    const Textblock & block = textpage.textblock( b );
+    for( int l = 0; l < block.textlines(); ++l )
+      {
+      const Textline & line = block.textline( l );
+      for( int c = 0; c < line.characters(); ++c )
+        {
+        const Character & ch = line.character( c );
+        for( int i = 0; i < ch.blobs(); ++i ) glyphs.push_back( &ch.blob( i ) );
+        }
+      }
+    }
+  }
+
+
+// Returns the best guess of each character of 'textpage', 0 if none.
+void collect_codes( const Textpage & textpage, std::vector< int > & codes )
+  {
+  for( int b = 0; b < textpage.textblocks(); ++b )
+    {
+    const Textblock & block = textpage.textblock( b );
+    for( int l = 0; l < block.textlines(); ++l )
+      {
+      const Textline & line = block.textline( l );
+      for( int c = 0; c < line.characters(); ++c )
+        {
+        const Character & ch = line.character( c );
+        codes.push_back( ch.guesses() ? ch.guess( 0 ).code : 0 );
+        }
+      }
+    }
+  }
+
+
+// Returns the number of insertions, deletions and substitutions needed
+// to transform 'a' into 'b'.
+int edit_distance( const std::vector< int > & a, const std::vector< int > & b )
+  {
+  std::vector< int > row( b.size() + 1 );
+  for( unsigned j = 0; j < row.size(); ++j ) row[j] = j;
+  for( unsigned i = 0; i < a.size(); ++i )
+    {
+    int diag = row[0]; row[0] = i + 1;
+    for( unsigned j = 0; j < b.size(); ++j )
+      {
+      const int up = row[j+1];
+      row[j+1] = std::min( std::min( up, row[j] ) + 1,
+                           diag + ( a[i] != b[j] ) );
+      diag = up;
+      }
+    }
+  return row.back();
+  }
+
+
+// Prints the best time of several runs recognizing 'page_image' at
+// each quality level, and the edit distance to the 'thorough' result.
+// The levels are run alternately so that they see the same conditions.
+void bench_quality( const Page_image & page_image, const std::string & name )
+  {
+  const char * const level_name[] = { "fast", "thorough" };
+  std::vector< int > codes[2];
+  long long best[2] = { -1, -1 };
+  for( int r = 0; r < runs; ++r )
+    for( int q = Control::fast; q <= Control::thorough; ++q )
+      {
+      Control control;
+      control.set_quality( q );
+      const long long start = Ocrad::nanoseconds();
+      const Textpage textpage( page_image, name.c_str(), control, false );
+      const long long t = Ocrad::nanoseconds() - start;
+      if( best[q] < 0 || t < best[q] ) best[q] = t;
+      if( r == 0 ) collect_codes( textpage, codes[q] );
+      }
+  for( int q = Control::fast; q <= Control::thorough; ++q )
+    std::printf( "  quality %-14s %10.2f ms/page   %5.1f%%  "
+                 "%4d of %d chars differ\n",
+                 level_name[q], best[q] / 1e6,
+                 100.0 * best[q] / best[Control::thorough],
+                 edit_distance( codes[q], codes[Control::thorough] ),
+                 (int)codes[Control::thorough].size() );
+  }
+
+
+int bench_page( const Page_image & page_image, const std::string & name,
+                long & sink )
+  {
+  const Control control;
+  const Textpage textpage( page_image, name.c_str(), control, false );
+  std::vector< const Blob * > glyphs;
+  collect_glyphs( textpage, glyphs );
+  if( glyphs.empty() )
+    { std::fprintf( stderr, "no glyphs found in '%s'\n", name.c_str() );
+      return 1; }
+  std::printf( "%s: %dw x %dh, %d glyphs\n", name.c_str(),
+               page_image.width(), page_image.height(), (int)glyphs.size() );
+  for( int i = 0; K_table[i].name != 0; ++i )
+    sink += bench( K_table[i], glyphs );
+  bench_quality( page_image, name );
+  return 0;
+  }
+
+} // end namespace
+
+
+int main( const int argc, const char * const argv[] )
+  {
+  if( argc < 2 )
+    {
+    std::fprintf( stderr, "Usage: ocradbench filename.pnm...\n" );
+    return 1;
+    }
+
+  int retval = 0;
+  long sink = 0;
+  for( int i = 1; i < argc; ++i )
+    {
+    FILE * const infile = std::fopen( argv[i], "rb" );
+    if( !infile )
+      {
+      std::fprintf( stderr, "Can't open file '%s' for reading\n", argv[i] );
+      retval = 1; continue;
+      }
+    try
+      {
+      Page_image page_image( infile, false );
+      page_image.threshold( -1 );			// auto threshold
+      if( bench_page( page_image, argv[i], sink ) != 0 ) retval = 1;
+      Page_image reduced( page_image );	// degraded, to exercise retries
+      if( reduced.change_scale( -2 ) )
+        {
+        std::printf( "%s / 2:\n", argv[i] );
+        bench_quality( reduced, std::string( argv[i] ) + " / 2" );
+        }
+      if( page_image.change_scale( 2 ) &&
+          bench_page( page_image, std::string( argv[i] ) + " x 2", sink ) != 0 )
+        retval = 1;
+      }
+    catch( Page_image::Error e )
+      { std::fprintf( stderr, "%s: %s\n", argv[i], e.msg ); retval = 2; }
+    std::fclose( infile );
+    }
+  if( sink == 42 ) std::fputs( "", stdout );	// use the results
+  return retval;
+  }
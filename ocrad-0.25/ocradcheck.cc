@@ -8,9 +8,13 @@
       ocradcheck filename.pnm
     or
       ocradcheck filename.pnm --utf8
+    or
+      ocradcheck filename.pnm -E filter_file
 
     This program reads the specified image file, feeds it to the OCR
-    engine and sends the resulting text to stdout.
+    engine and sends the resulting text to stdout. With '-E', the user
+    filter 'filter_file' is applied and each image is recognized with a
+    threshold sweep.
 */
 
 #include <cstdio>
@@ -22,54 +26,18 @@
 #include "ocradlib.h"
 
 
-int main( const int argc, const char * const argv[] )
+// Recognizes the current image of 'ocrdes' and prints the text found.
+// Returns 0 if OK, else the exit status.
+int check_image( OCRAD_Descriptor * const ocrdes, const bool utf8,
+                 const char * const filter_file )
   {
-  const bool utf8 = ( argc > 2 );
-  if( argc < 2 )
+  const int thresholds[3] = { 77, -1, 179 };	// 0.3, auto, 70%
+  if( OCRAD_set_threshold( ocrdes, -1 ) < 0 ||	// auto threshold
+      ( filter_file ?
+        OCRAD_recognize_sweep( ocrdes, false, thresholds, 3 ) :
+        OCRAD_recognize( ocrdes, false ) ) < 0 )	// no layout
     {
-    std::fprintf( stderr, "Usage: ocradcheck filename.pnm\n" );
-    return 1;
-    }
-
-  if( OCRAD_version()[0] != OCRAD_version_string[0] )
-    {
-    std::fprintf( stderr, "bad library version" );
-    return 3;
-    }
-
-  if( std::strcmp( PROGVERSION, OCRAD_version_string ) != 0 )
-    {
-    std::fprintf( stderr, "bad library version_string" );
-    return 3;
-    }
-
-  OCRAD_Descriptor * const ocrdes = OCRAD_open();
-  if( !ocrdes || OCRAD_get_errno( ocrdes ) != OCRAD_ok )
-    {
-    OCRAD_close( ocrdes );
-    std::fprintf( stderr, "not enough memory.\n" );
-    return 1;
-    }
-
-  if( OCRAD_set_image_from_file( ocrdes, argv[1], false ) < 0 )
-    {
-    const OCRAD_Errno ocr_errno = OCRAD_get_errno( ocrdes );
-    OCRAD_close( ocrdes );
-    if( ocr_errno == OCRAD_mem_error )
-      std::fprintf( stderr, "not enough memory.\n" );
-    else
-      std::fprintf( stderr, "Can't open file '%s' for reading\n", argv[1] );
-    return 1;
-    }
-//  std::fprintf( stderr, "ocradcheck: testing file '%s'\n", argv[1] );
-
-  if( ( utf8 && OCRAD_set_utf8_format( ocrdes, true ) < 0 ) ||
-      OCRAD_set_threshold( ocrdes, -1 ) < 0 ||	// auto threshold
-      OCRAD_recognize( ocrdes, false ) < 0 )	// no layout
-    {
-    const OCRAD_Errno ocr_errno = OCRAD_get_errno( ocrdes );
-    OCRAD_close( ocrdes );
-    if( ocr_errno == OCRAD_mem_error )
+    if( OCRAD_get_errno( ocrdes ) == OCRAD_mem_error )
       {
       std::fprintf( stderr, "not enough memory.\n" );
       return 1;
@@ -77,6 +45,16 @@ int main( const int argc, const char * const argv[] )
     std::fprintf( stderr, "internal error: invalid argument.\n" );
     return 3;
     }
+  // Filtering again the same results must not change them.
+  if( OCRAD_add_filter( ocrdes, "numbers_only" ) < 0 ||
+      OCRAD_apply_filters( ocrdes ) < 0 ||
+      OCRAD_clear_filters( ocrdes ) < 0 ||
+      ( filter_file && OCRAD_add_user_filter( ocrdes, filter_file ) < 0 ) ||
+      OCRAD_apply_filters( ocrdes ) < 0 )
+    {
+    std::fprintf( stderr, "library error: can't apply filters.\n" );
+    return 1;
+    }
 
   const int blocks = OCRAD_result_blocks( ocrdes );
   int chars_total_by_block = 0;
@@ -89,7 +67,16 @@ int main( const int argc, const char * const argv[] )
     for( int l = 0; l < lines; ++l )
       {
       const char * const s = OCRAD_result_line( ocrdes, b, l );
-      chars_total_by_line += OCRAD_result_chars_line( ocrdes, b, l );
+      const int chars = OCRAD_result_chars_line( ocrdes, b, l );
+      const int * const table = OCRAD_result_line_table( ocrdes, b, l );
+      chars_total_by_line += chars;
+      if( !table )
+        { std::fprintf( stderr, "library_error: no line table.\n" );
+          return 1; }
+      for( int i = 0; i < chars; ++i )		// left <= right, top <= bottom
+        if( table[i] > table[2*chars+i] || table[chars+i] > table[3*chars+i] )
+          { std::fprintf( stderr, "library_error: bad character box.\n" );
+            return 1; }
       if( s && s[0] )
         {
         std::printf( "%s", s );
@@ -115,6 +102,71 @@ int main( const int argc, const char * const argv[] )
     return 1;
     }
 
-  OCRAD_close( ocrdes );
   return 0;
   }
+
+
+int main( const int argc, const char * const argv[] )
+  {
+  const bool utf8 = ( argc == 3 && std::strcmp( argv[2], "--utf8" ) == 0 );
+  const char * const filter_file =
+    ( argc == 4 && std::strcmp( argv[2], "-E" ) == 0 ) ? argv[3] : 0;
+  if( argc < 2 || ( argc > 2 && !utf8 && !filter_file ) )
+    {
+    std::fprintf( stderr, "Usage: ocradcheck filename.pnm\n" );
+    return 1;
+    }
+
+  if( OCRAD_version()[0] != OCRAD_version_string[0] )
+    {
+    std::fprintf( stderr, "bad library version" );
+    return 3;
+    }
+
+  if( std::strcmp( PROGVERSION, OCRAD_version_string ) != 0 )
+    {
+    std::fprintf( stderr, "bad library version_string" );
+    return 3;
+    }
+
+  OCRAD_Descriptor * const ocrdes = OCRAD_open();
+  if( !ocrdes || OCRAD_get_errno( ocrdes ) != OCRAD_ok )
+    {
+    OCRAD_close( ocrdes );
+    std::fprintf( stderr, "not enough memory.\n" );
+    return 1;
+    }
+
+  if( OCRAD_set_image_from_file( ocrdes, argv[1], false ) < 0 )
+    {
+    const OCRAD_Errno ocr_errno = OCRAD_get_errno( ocrdes );
+    OCRAD_close( ocrdes );
+    if( ocr_errno == OCRAD_mem_error )
+      std::fprintf( stderr, "not enough memory.\n" );
+    else
+      std::fprintf( stderr, "Can't open file '%s' for reading\n", argv[1] );
+    return 1;
+    }
+//  std::fprintf( stderr, "ocradcheck: testing file '%s'\n", argv[1] );
+
+  int retval = 0;
+  if( ( utf8 && OCRAD_set_utf8_format( ocrdes, true ) < 0 ) ||
+      ( filter_file && OCRAD_add_user_filter( ocrdes, filter_file ) < 0 ) ||
+      OCRAD_set_incremental( ocrdes, true ) < 0 )	// images are alike
+    {
+    std::fprintf( stderr, "internal error: invalid argument.\n" );
+    retval = 3;
+    }
+  while( retval == 0 )				// for every image in file
+    {
+    retval = check_image( ocrdes, utf8, filter_file );
+    if( retval != 0 ) break;
+    const int tmp = OCRAD_next_image( ocrdes );
+    if( tmp == 0 ) break;
+    if( tmp < 0 )
+      { std::fprintf( stderr, "error reading next image.\n" ); retval = 2; }
+    }
+
+  OCRAD_close( ocrdes );
+  return retval;
+  }
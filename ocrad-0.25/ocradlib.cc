@@ -15,44 +15,122 @@
     along with this library.  If not, see <http://www.gnu.org/licenses/>.
 */
 
+#include <algorithm>
 #include <climits>
 #include <cstdio>
 #include <cstring>
 #include <string>
 #include <vector>
 #include <stdint.h>
+#include <sys/stat.h>
 
 #include "ocradlib.h"
 #include "common.h"
+#include "parallel.h"
 #include "rectangle.h"
 #include "ucs.h"
 #include "track.h"
 #include "bitmap.h"
 #include "blob.h"
 #include "character.h"
+#include "frame_cache.h"
 #include "page_image.h"
 #include "textline.h"
 #include "textblock.h"
 #include "textpage.h"
+#include "result_cache.h"
+#include "trace.h"
 
 
 struct OCRAD_Descriptor
   {
   Page_image * page_image;
   Textpage * textpage;
+  std::vector< Textpage * > sweep;	// results of the last threshold sweep
+  Frame_cache * cache;		// results of the last frame, if incremental
+  Result_cache * result_cache;	// results stored on disk, if any
   OCRAD_Errno ocr_errno;
   Control control;
   std::string text;
+  FILE * infile;		// multi-image stream being read
+  Page_image * next_image;	// next image of infile, if already decoded
+  OCRAD_Errno next_errno;	// error found decoding next_image
+  bool invert;			// invert levels of images read from infile
+  bool layout;			// used by the recognize job
 
   OCRAD_Descriptor()
     :
     page_image( 0 ),
     textpage( 0 ),
-    ocr_errno( OCRAD_ok )
-    { control.outfile = 0; }
+    cache( 0 ),
+    result_cache( 0 ),
+    ocr_errno( OCRAD_ok ),
+    infile( 0 ),
+    next_image( 0 ),
+    next_errno( OCRAD_ok ),
+    invert( false ),
+    layout( false )
+    { control.outfile = 0; control.keep_unfiltered = true; }
   };
 
 
+void close_exportfile( OCRAD_Descriptor * const ocrdes )
+  {
+  FILE * const f = ocrdes->control.exportfile;
+  if( f && f != stdout ) std::fclose( f );
+  ocrdes->control.exportfile = 0;
+  }
+
+
+void close_stream( OCRAD_Descriptor * const ocrdes )
+  {
+  if( ocrdes->infile ) { std::fclose( ocrdes->infile ); ocrdes->infile = 0; }
+  if( ocrdes->next_image )
+    { delete ocrdes->next_image; ocrdes->next_image = 0; }
+  ocrdes->next_errno = OCRAD_ok;
+  }
+
+
+// Decodes the next image of the stream into 'next_image'. Closes the
+// stream if there are no more images or in case of error.
+void decode_next_image( OCRAD_Descriptor * const ocrdes )
+  {
+  try
+    {
+    if( Page_image::more_images( ocrdes->infile ) )
+      {
+      const Trace::Span span( "decode" );
+      ocrdes->next_image = new Page_image( ocrdes->infile, ocrdes->invert,
+                                           ocrdes->control.memory_budget() );
+      return;
+      }
+    }
+  catch( std::bad_alloc ) { ocrdes->next_errno = OCRAD_mem_error; }
+  catch( ... ) { ocrdes->next_errno = OCRAD_bad_argument; }
+  std::fclose( ocrdes->infile ); ocrdes->infile = 0;
+  }
+
+
+// Deletes the results. 'textpage' is one of 'sweep' if 'sweep' is not
+// empty.
+void delete_results( OCRAD_Descriptor * const ocrdes )
+  {
+  if( ocrdes->sweep.empty() ) delete ocrdes->textpage;
+  for( unsigned i = 0; i < ocrdes->sweep.size(); ++i ) delete ocrdes->sweep[i];
+  ocrdes->sweep.clear();
+  ocrdes->textpage = 0;
+  }
+
+
+void set_page_image( OCRAD_Descriptor * const ocrdes,
+                     Page_image * const page_image )
+  {
+  delete_results( ocrdes );
+  if( ocrdes->page_image ) delete ocrdes->page_image;
+  ocrdes->page_image = page_image;
+  }
+
+
 bool verify_descriptor( OCRAD_Descriptor * const ocrdes,
                         const bool result = false )
   {
@@ -78,7 +156,11 @@ OCRAD_Descriptor * OCRAD_open()
 int OCRAD_close( OCRAD_Descriptor * const ocrdes )
   {
   if( !ocrdes ) return -1;
-  if( ocrdes->textpage ) delete ocrdes->textpage;
+  close_stream( ocrdes );
+  close_exportfile( ocrdes );
+  delete_results( ocrdes );
+  delete ocrdes->cache;
+  delete ocrdes->result_cache;
   if( ocrdes->page_image ) delete ocrdes->page_image;
   delete ocrdes;
   return 0;
@@ -101,14 +183,17 @@ int OCRAD_set_image( OCRAD_Descriptor * const ocrdes,
       ( image->mode != OCRAD_bitmap && image->mode != OCRAD_greymap &&
         image->mode != OCRAD_colormap ) )
     { ocrdes->ocr_errno = OCRAD_bad_argument; return -1; }
+  const long long budget = ocrdes->control.memory_budget();
+  if( budget > 0 && (long long)image->width * image->height > budget )
+    { ocrdes->ocr_errno = OCRAD_mem_error; return -1; }
 
   try
     {
+    Trace::Span span( "decode" );
     Page_image * const page_image = new Page_image( *image, invert );
-    if( ocrdes->textpage )
-      { delete ocrdes->textpage; ocrdes->textpage = 0; }
-    if( ocrdes->page_image ) delete ocrdes->page_image;
-    ocrdes->page_image = page_image;
+    span.end();
+    close_stream( ocrdes );
+    set_page_image( ocrdes, page_image );
     }
   catch( std::bad_alloc )
     { ocrdes->ocr_errno = OCRAD_mem_error; return -1; }
@@ -127,21 +212,39 @@ int OCRAD_set_image_from_file( OCRAD_Descriptor * const ocrdes,
     else infile = std::fopen( filename, "rb" );
     }
   if( !infile ) { ocrdes->ocr_errno = OCRAD_bad_argument; return -1; }
-  int retval = 0;
   try
     {
-    Page_image * const page_image = new Page_image( infile, invert );
-    if( ocrdes->textpage )
-      { delete ocrdes->textpage; ocrdes->textpage = 0; }
-    if( ocrdes->page_image ) delete ocrdes->page_image;
-    ocrdes->page_image = page_image;
+    Trace::Span span( "decode" );
+    Page_image * const page_image =
+      new Page_image( infile, invert, ocrdes->control.memory_budget() );
+    span.end();
+    close_stream( ocrdes );
+    set_page_image( ocrdes, page_image );
     }
   catch( std::bad_alloc )
-    { ocrdes->ocr_errno = OCRAD_mem_error; retval = -1; }
+    { ocrdes->ocr_errno = OCRAD_mem_error; std::fclose( infile ); return -1; }
   catch( ... )
-    { ocrdes->ocr_errno = OCRAD_bad_argument; retval = -1; }
-  std::fclose( infile );
-  return retval;
+    { ocrdes->ocr_errno = OCRAD_bad_argument; std::fclose( infile ); return -1; }
+  ocrdes->infile = infile;		// keep it open for OCRAD_next_image
+  ocrdes->invert = invert;
+  return 0;
+  }
+
+
+int OCRAD_next_image( OCRAD_Descriptor * const ocrdes )
+  {
+  if( !verify_descriptor( ocrdes ) ) return -1;
+  if( !ocrdes->next_image && ocrdes->infile ) decode_next_image( ocrdes );
+  if( ocrdes->next_errno != OCRAD_ok )
+    {
+    ocrdes->ocr_errno = ocrdes->next_errno;
+    ocrdes->next_errno = OCRAD_ok;
+    return -1;
+    }
+  if( !ocrdes->next_image ) return 0;			// end of stream
+  set_page_image( ocrdes, ocrdes->next_image );
+  ocrdes->next_image = 0;
+  return 1;
   }
 
 
@@ -153,6 +256,105 @@ int OCRAD_set_utf8_format( OCRAD_Descriptor * const ocrdes, const bool utf8 )
   }
 
 
+int OCRAD_set_threads( OCRAD_Descriptor * const ocrdes, const int threads )
+  {
+  if( !ocrdes ) return -1;
+  if( !ocrdes->control.set_threads( threads ) )
+    { ocrdes->ocr_errno = OCRAD_bad_argument; return -1; }
+  return 0;
+  }
+
+
+int OCRAD_set_despeckle( OCRAD_Descriptor * const ocrdes, const int size )
+  {
+  if( !ocrdes ) return -1;
+  if( !ocrdes->control.set_despeckle( size ) )
+    { ocrdes->ocr_errno = OCRAD_bad_argument; return -1; }
+  return 0;
+  }
+
+
+int OCRAD_set_coarse_layout( OCRAD_Descriptor * const ocrdes,
+                             const bool coarse )
+  {
+  if( !ocrdes ) return -1;
+  ocrdes->control.coarse_layout = coarse;
+  return 0;
+  }
+
+
+int OCRAD_set_incremental( OCRAD_Descriptor * const ocrdes,
+                           const bool incremental )
+  {
+  if( !ocrdes ) return -1;
+  if( !incremental ) { delete ocrdes->cache; ocrdes->cache = 0; }
+  else if( !ocrdes->cache )
+    {
+    ocrdes->cache = new( std::nothrow ) Frame_cache;
+    if( !ocrdes->cache ) { ocrdes->ocr_errno = OCRAD_mem_error; return -1; }
+    }
+  return 0;
+  }
+
+
+int OCRAD_set_cache( OCRAD_Descriptor * const ocrdes,
+                     const char * const dirname, const int megabytes )
+  {
+  if( !ocrdes ) return -1;
+  if( megabytes < 0 || megabytes > Result_cache::max_size )
+    { ocrdes->ocr_errno = OCRAD_bad_argument; return -1; }
+  delete ocrdes->result_cache; ocrdes->result_cache = 0;
+  if( dirname && dirname[0] )
+    {
+    ocrdes->result_cache = new( std::nothrow )
+      Result_cache( dirname, megabytes * 1048576LL );
+    if( !ocrdes->result_cache )
+      { ocrdes->ocr_errno = OCRAD_mem_error; return -1; }
+    }
+  return 0;
+  }
+
+
+int OCRAD_set_memory_limit( OCRAD_Descriptor * const ocrdes,
+                            const int megabytes )
+  {
+  if( !ocrdes ) return -1;
+  if( !ocrdes->control.set_memory_limit( megabytes ) )
+    { ocrdes->ocr_errno = OCRAD_bad_argument; return -1; }
+  return 0;
+  }
+
+
+int OCRAD_set_trace_file( OCRAD_Descriptor * const ocrdes,
+                          const char * const filename )
+  {
+  if( !ocrdes ) return -1;
+  if( !filename || !filename[0] ) { Trace::close(); return 0; }
+  if( !Trace::open( filename ) )
+    { ocrdes->ocr_errno = OCRAD_bad_argument; return -1; }
+  return 0;
+  }
+
+
+int OCRAD_set_quality( OCRAD_Descriptor * const ocrdes, const int quality )
+  {
+  if( !ocrdes ) return -1;
+  if( !ocrdes->control.set_quality( quality ) )
+    { ocrdes->ocr_errno = OCRAD_bad_argument; return -1; }
+  return 0;
+  }
+
+
+int OCRAD_set_adaptive_threshold( OCRAD_Descriptor * const ocrdes,
+                                  const int window )
+  {
+  if( !ocrdes ) return -1;
+  if( !ocrdes->control.set_window( window ) )
+    { ocrdes->ocr_errno = OCRAD_bad_argument; return -1; }
+  return 0;
+  }
+
+
 int OCRAD_set_threshold( OCRAD_Descriptor * const ocrdes, const int threshold )
   {
   if( !verify_descriptor( ocrdes ) ) return -1;
@@ -173,6 +375,20 @@ int OCRAD_scale( OCRAD_Descriptor * const ocrdes, const int value )
   return retval;
   }
 
+
+int OCRAD_auto_scale( OCRAD_Descriptor * const ocrdes )
+  {
+  if( !verify_descriptor( ocrdes ) ) return -1;
+  try
+    {
+    Page_image & page_image = *ocrdes->page_image;
+    page_image.change_scale( Textpage::auto_scale( page_image, ocrdes->control ) );
+    }
+  catch( std::bad_alloc ) { ocrdes->ocr_errno = OCRAD_mem_error; return -1; }
+  catch( ... ) { ocrdes->ocr_errno = OCRAD_library_error; return -1; }
+  return 0;
+  }
+
 int OCRAD_transform( OCRAD_Descriptor * const ocrdes, const char * const transformation )
   {
   if( !verify_descriptor( ocrdes ) ) return -1;
@@ -194,6 +410,7 @@ int OCRAD_set_exportfile( OCRAD_Descriptor * const ocrdes, const char * const fi
     }
   if( !exportfile ) { ocrdes->ocr_errno = OCRAD_bad_argument; return -1; }
 
+  close_exportfile( ocrdes );
   ocrdes->control.exportfile = exportfile;
   return 0;
   }
@@ -206,21 +423,186 @@ int OCRAD_add_filter( OCRAD_Descriptor * const ocrdes, const char * const name)
   }
 
 
+int OCRAD_add_user_filter( OCRAD_Descriptor * const ocrdes,
+                           const char * const filename )
+  {
+  if( !ocrdes ) return -1;
+  if( !filename ) { ocrdes->ocr_errno = OCRAD_bad_argument; return -1; }
+  try
+    {
+    if( ocrdes->control.add_user_filter( "", filename ) != 0 )
+      { ocrdes->ocr_errno = OCRAD_bad_argument; return -1; }
+    }
+  catch( std::bad_alloc ) { ocrdes->ocr_errno = OCRAD_mem_error; return -1; }
+  return 0;
+  }
+
+
+int OCRAD_clear_filters( OCRAD_Descriptor * const ocrdes )
+  {
+  if( !ocrdes ) return -1;
+  ocrdes->control.clear_filters();
+  return 0;
+  }
+
+
+namespace {
+
+// Job 0 recognizes the current image. Job 1 decodes the next image of
+// the stream, if any. Errors are returned in 'ocr_errno' and
+// 'next_errno'; no exception leaves a job.
+void recognize_job( void * const arg, const int i )
+  {
+  OCRAD_Descriptor * const ocrdes = (OCRAD_Descriptor *)arg;
+  if( i == 0 )
+    {
+    Textpage * textpage = 0;
+    try
+      {
+      if( !Textpage::fit_memory( *ocrdes->page_image, ocrdes->control ) )
+        { ocrdes->ocr_errno = OCRAD_mem_error; return; }
+      const Page_image & page_image = *ocrdes->page_image;
+      const Result_cache * const result_cache = ocrdes->result_cache;
+      std::string key;
+      if( result_cache )
+        {
+        const Trace::Span span( "cache_find" );
+        key = Result_cache::key( page_image, page_image.threshold(),
+                                 ocrdes->control, ocrdes->layout );
+        textpage = result_cache->find( key, "" );
+        }
+      if( !textpage )
+        {
+        textpage = new Textpage( page_image, "", ocrdes->control,
+                                 ocrdes->layout, -1, ocrdes->cache );
+        if( result_cache ) result_cache->store( key, *textpage );
+        }
+      }
+    catch( std::bad_alloc )
+      { delete textpage; ocrdes->ocr_errno = OCRAD_mem_error; return; }
+    catch( ... )
+      { delete textpage; ocrdes->ocr_errno = OCRAD_library_error; return; }
+    delete_results( ocrdes );
+    ocrdes->textpage = textpage;
+    }
+  else decode_next_image( ocrdes );
+  }
+
+
+// Only regular files are read ahead. Reading ahead a pipe could block
+// until the producer writes the next image.
+bool read_ahead( const OCRAD_Descriptor * const ocrdes )
+  {
+  struct stat st;
+  return ( ocrdes->infile && !ocrdes->next_image &&
+           ocrdes->next_errno == OCRAD_ok &&
+           fstat( fileno( ocrdes->infile ), &st ) == 0 &&
+           S_ISREG( st.st_mode ) );
+  }
+
+} // end namespace
+
+
 int OCRAD_recognize( OCRAD_Descriptor * const ocrdes, const bool layout )
   {
   if( !verify_descriptor( ocrdes ) ) return -1;
-  Textpage * const textpage =
-    new( std::nothrow ) Textpage( *ocrdes->page_image, "",
-                                  ocrdes->control, layout );
-  if( !textpage )
-    { ocrdes->ocr_errno = OCRAD_mem_error; return -1; }
-  if( ocrdes->textpage ) delete ocrdes->textpage;
-  ocrdes->textpage = textpage;
-  if( ocrdes->control.exportfile ) textpage->xprint( ocrdes->control );
+  const OCRAD_Errno old_errno = ocrdes->ocr_errno;
+  ocrdes->ocr_errno = OCRAD_ok;
+  ocrdes->layout = layout;
+  if( read_ahead( ocrdes ) )
+    Ocrad::parallel_run( recognize_job, ocrdes, 2, 2 );
+  else recognize_job( ocrdes, 0 );
+  if( ocrdes->ocr_errno != OCRAD_ok ) return -1;
+  ocrdes->ocr_errno = old_errno;
+  if( ocrdes->control.exportfile )
+    ocrdes->textpage->xprint( ocrdes->control );
   return 0;
   }
 
 
+int OCRAD_recognize_sweep( OCRAD_Descriptor * const ocrdes, const bool layout,
+                           const int thresholds[], const int count )
+  {
+  if( !verify_descriptor( ocrdes ) ) return -1;
+  if( !thresholds || count <= 0 )
+    { ocrdes->ocr_errno = OCRAD_bad_argument; return -1; }
+  Page_image & page_image = *ocrdes->page_image;
+  std::vector< int > levels;
+  for( int i = 0; i < count; ++i )
+    {
+    if( thresholds[i] < -1 || thresholds[i] > 255 )
+      { ocrdes->ocr_errno = OCRAD_bad_argument; return -1; }
+    levels.push_back( page_image.threshold_level( thresholds[i] ) );
+    }
+  std::vector< Textpage * > sweep;
+  try
+    {
+    if( !Textpage::fit_memory( page_image, ocrdes->control ) )
+      { ocrdes->ocr_errno = OCRAD_mem_error; return -1; }
+    Textpage::sweep( page_image, "", ocrdes->control, layout, levels, sweep );
+    }
+  catch( std::bad_alloc ) { ocrdes->ocr_errno = OCRAD_mem_error; return -1; }
+  int best = 0;
+  for( int i = 0; i < count; ++i )
+    {
+    if( !sweep[i] )
+      {
+      for( int j = 0; j < count; ++j ) delete sweep[j];
+      ocrdes->ocr_errno = OCRAD_mem_error; return -1;
+      }
+    if( sweep[i]->score() > sweep[best]->score() ) best = i;
+    }
+  delete_results( ocrdes );
+  ocrdes->sweep.swap( sweep );
+  ocrdes->textpage = ocrdes->sweep[best];
+  if( ocrdes->control.exportfile )
+    ocrdes->textpage->xprint( ocrdes->control );
+  return best;
+  }
+
+
+// The results of a threshold sweep are all filtered again. Results read
+// from the result cache don't keep a copy before the filters, and are
+// recognized again (or read again from the cache) instead.
+int OCRAD_apply_filters( OCRAD_Descriptor * const ocrdes )
+  {
+  if( !verify_descriptor( ocrdes, true ) ) return -1;
+  const OCRAD_Errno old_errno = ocrdes->ocr_errno;
+  ocrdes->ocr_errno = OCRAD_ok;
+  try
+    {
+    if( !ocrdes->sweep.empty() )
+      for( unsigned i = 0; i < ocrdes->sweep.size(); ++i )
+        ocrdes->sweep[i]->apply_filters( ocrdes->control );
+    else if( !ocrdes->textpage->apply_filters( ocrdes->control ) )
+      recognize_job( ocrdes, 0 );
+    }
+  catch( std::bad_alloc ) { ocrdes->ocr_errno = OCRAD_mem_error; }
+  if( ocrdes->ocr_errno != OCRAD_ok ) return -1;
+  ocrdes->ocr_errno = old_errno;
+  if( ocrdes->control.exportfile )
+    ocrdes->textpage->xprint( ocrdes->control );
+  return 0;
+  }
+
+
+int OCRAD_result_select( OCRAD_Descriptor * const ocrdes, const int index )
+  {
+  if( !verify_descriptor( ocrdes, true ) ) return -1;
+  if( index < 0 || index >= (int)ocrdes->sweep.size() )
+    { ocrdes->ocr_errno = OCRAD_bad_argument; return -1; }
+  ocrdes->textpage = ocrdes->sweep[index];
+  return 0;
+  }
+
+
+int OCRAD_result_score( OCRAD_Descriptor * const ocrdes )
+  {
+  if( !verify_descriptor( ocrdes, true ) ) return -1;
+  return std::max( 0, ocrdes->textpage->score() );
+  }
+
+
 int OCRAD_result_blocks( OCRAD_Descriptor * const ocrdes )
   {
   if( !verify_descriptor( ocrdes, true ) ) return -1;
@@ -284,34 +666,60 @@ const char * OCRAD_result_line( OCRAD_Descriptor * const ocrdes,
     { ocrdes->ocr_errno = OCRAD_bad_argument; return 0; }
   const Textline & textline =
     ocrdes->textpage->textblock( blocknum ).textline( linenum );
+  const int * const code = textline.column( Textline::c_code );
   ocrdes->text.clear();
-  if( !ocrdes->control.utf8 )
-    for( int i = 0; i < textline.characters(); ++i )
-      ocrdes->text += textline.character( i ).byte_result();
-  else
-    for( int i = 0; i < textline.characters(); ++i )
-      ocrdes->text += textline.character( i ).utf8_result();
+  for( int i = 0; i < textline.characters(); ++i )
+    {
+    if( code[i] < 0 ) { ocrdes->text += '_'; continue; }
+    if( !ocrdes->control.utf8 )
+      {
+      const unsigned char ch = UCS::map_to_byte( code[i] );
+      ocrdes->text += ch ? ch : '_';
+      }
+    else
+      {
+      const char * const s = UCS::ucs_to_utf8( code[i] );
+      ocrdes->text += *s ? s : "_";
+      }
+    }
   ocrdes->text += '\n';
   return ocrdes->text.c_str();
   }
 
 
+const int * OCRAD_result_line_table( OCRAD_Descriptor * const ocrdes,
+                                     const int blocknum, const int linenum )
+  {
+  if( !verify_descriptor( ocrdes, true ) ) return 0;
+  if( blocknum < 0 || blocknum >= ocrdes->textpage->textblocks() ||
+      linenum < 0 ||
+      linenum >= ocrdes->textpage->textblock( blocknum ).textlines() )
+    { ocrdes->ocr_errno = OCRAD_bad_argument; return 0; }
+  return ocrdes->textpage->textblock( blocknum ).textline( linenum ).
+         column( Textline::c_left );
+  }
+
+
 int OCRAD_result_first_character( OCRAD_Descriptor * const ocrdes )
   {
   if( !verify_descriptor( ocrdes, true ) ) return -1;
   int ch = 0;
   if( ocrdes->textpage->textblocks() > 0 &&
-      ocrdes->textpage->textblock( 0 ).textlines() > 0 )
+      ocrdes->textpage->textblock( 0 ).textlines() > 0 &&
+      ocrdes->textpage->textblock( 0 ).textline( 0 ).characters() > 0 )
     {
-    const Character & character =
-      ocrdes->textpage->textblock( 0 ).textline( 0 ).character( 0 );
-    if( character.guesses() )
-      {
-      if( !ocrdes->control.utf8 )
-        ch = UCS::map_to_byte( character.guess( 0 ).code );
-      else
-        ch = character.guess( 0 ).code;
-      }
+    const int code = *ocrdes->textpage->textblock( 0 ).textline( 0 ).
+                      column( Textline::c_code );
+    if( code >= 0 )
+      ch = ocrdes->control.utf8 ? code : UCS::map_to_byte( code );
     }
   return ch;
   }
+
+
+int OCRAD_result_memory_peak( OCRAD_Descriptor * const ocrdes )
+  {
+  if( !verify_descriptor( ocrdes, true ) ) return -1;
+  const long long kib = ocrdes->textpage->memory_peak() / 1024;
+  return ( kib < INT_MAX ) ? kib : INT_MAX;
+  }
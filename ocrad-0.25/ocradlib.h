@@ -43,6 +43,12 @@ struct OCRAD_Pixmap
 enum OCRAD_Errno { OCRAD_ok = 0, OCRAD_bad_argument, OCRAD_mem_error,
                    OCRAD_sequence_error, OCRAD_library_error };
 
+/* OCRAD_fast skips the retries on characters left unrecognized by the
+   first pass and the joining and splitting of characters. It is much
+   faster on degraded images, but may read for example a double quote as
+   two single quotes. OCRAD_thorough runs every recognition pass. */
+enum OCRAD_Quality { OCRAD_fast = 0, OCRAD_thorough };
+
 struct OCRAD_Descriptor;
 
 
@@ -65,6 +71,8 @@ int OCRAD_set_image_from_file( struct OCRAD_Descriptor * const ocrdes,
                                const char * const filename,
                                const bool invert );
 
+int OCRAD_next_image( struct OCRAD_Descriptor * const ocrdes );
+
 int OCRAD_set_utf8_format( struct OCRAD_Descriptor * const ocrdes,
                            const bool utf8 );		// 0 = byte, 1 = utf8
 
@@ -74,17 +82,64 @@ int OCRAD_set_exportfile( struct OCRAD_Descriptor * const ocrdes,
 int OCRAD_add_filter( struct OCRAD_Descriptor * const ocrdes,
                                const char * const name);
 
+int OCRAD_add_user_filter( struct OCRAD_Descriptor * const ocrdes,
+                           const char * const filename );
+
+int OCRAD_clear_filters( struct OCRAD_Descriptor * const ocrdes );
+
+int OCRAD_set_threads( struct OCRAD_Descriptor * const ocrdes,
+                       const int threads );	// 0 = all processors
+
+int OCRAD_set_despeckle( struct OCRAD_Descriptor * const ocrdes,
+                         const int size );	// 0 = no despeckle
+
+int OCRAD_set_coarse_layout( struct OCRAD_Descriptor * const ocrdes,
+                             const bool coarse );
+
+int OCRAD_set_incremental( struct OCRAD_Descriptor * const ocrdes,
+                           const bool incremental );
+
+int OCRAD_set_cache( struct OCRAD_Descriptor * const ocrdes,
+                     const char * const dirname,	// 0 = no cache
+                     const int megabytes );	// 0 = no limit
+
+int OCRAD_set_memory_limit( struct OCRAD_Descriptor * const ocrdes,
+                            const int megabytes );	// 0 = no limit
+
+int OCRAD_set_trace_file( struct OCRAD_Descriptor * const ocrdes,
+                          const char * const filename );	// 0 = close
+
+int OCRAD_set_quality( struct OCRAD_Descriptor * const ocrdes,
+                       const int quality );	// OCRAD_Quality
+
 int OCRAD_set_threshold( struct OCRAD_Descriptor * const ocrdes,
                          const int threshold );		// 0..255, -1 = auto
 
+int OCRAD_set_adaptive_threshold( struct OCRAD_Descriptor * const ocrdes,
+                                  const int window );	// 0 = global
+
 int OCRAD_scale( struct OCRAD_Descriptor * const ocrdes, const int value );
 
+int OCRAD_auto_scale( struct OCRAD_Descriptor * const ocrdes );
+
 int OCRAD_transform( OCRAD_Descriptor * const ocrdes,
                         const char * const transformation );
 
 int OCRAD_recognize( struct OCRAD_Descriptor * const ocrdes,
                      const bool layout );
 
+int OCRAD_recognize_sweep( struct OCRAD_Descriptor * const ocrdes,
+                           const bool layout,
+                           const int thresholds[],	// 0..255, -1 = auto
+                           const int count );
+
+int OCRAD_apply_filters( struct OCRAD_Descriptor * const ocrdes );
+
+int OCRAD_result_select( struct OCRAD_Descriptor * const ocrdes,
+                         const int index );		// 0..count-1
+
+int OCRAD_result_score( struct OCRAD_Descriptor * const ocrdes );
+
 int OCRAD_result_blocks( struct OCRAD_Descriptor * const ocrdes );
 
 int OCRAD_result_lines( struct OCRAD_Descriptor * const ocrdes,
@@ -103,8 +158,18 @@ const char * OCRAD_result_line( struct OCRAD_Descriptor * const ocrdes,
                                 const int blocknum,	// 0..blocks-1
                                 const int linenum );	// 0..lines(block)-1
 
+/* Returns 7 arrays of chars_line ints each, one after another: left,
+   top, right, bottom, code (UCS, -1 = unrecognized), value and number
+   of guesses of the characters of the line. Valid until the results
+   change. */
+const int * OCRAD_result_line_table( struct OCRAD_Descriptor * const ocrdes,
+                                     const int blocknum,
+                                     const int linenum );
+
 int OCRAD_result_first_character( struct OCRAD_Descriptor * const ocrdes );
 
+int OCRAD_result_memory_peak( struct OCRAD_Descriptor * const ocrdes );	// KiB
+
 #ifdef __cplusplus
 }
 #endif
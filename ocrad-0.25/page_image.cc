@@ -301,39 +301,6 @@ void mirror_top_bottom( std::vector< std::vector< uint8_t > > & data )
   }
 
 
-void mirror_diagonal( std::vector< std::vector< uint8_t > > & data,
-                      Rectangle & re )
-  {
-  const int size = std::max( re.height(), re.width() );
-
-  if( re.height() < size )
-    {
-    data.resize( size );
-    for( int row = re.height(); row < size; ++row )
-      data[row].resize( size );
-    }
-  else if( re.width() < size )
-    for( int row = 0; row < re.height(); ++row )
-      data[row].resize( size );
-
-  for( int row = 0; row < size; ++row )
-    {
-    std::vector< uint8_t > & datarow = data[row];
-    for( int col = 0; col < row; ++col )
-      {
-      uint8_t tmp = datarow[col];
-      datarow[col] = data[col][row]; data[col][row] = tmp;
-      }
-    }
-
-  const int h = re.height(), w = re.width();
-  re.height( w ); re.width( h );
-  if( re.height() < size ) data.resize( re.height() );
-  else if( re.width() < size )
-    for( int row = 0; row < re.height(); ++row )
-      data[row].resize( re.width() );
-  }
-
 } // end namespace
 
 
@@ -424,18 +391,24 @@ Page_image::Page_image( const Page_image & source, const int scale )
 
 
 void Page_image::threshold( const Rational & th )
+  { threshold_ = threshold_level( th ); }
+
+
+void Page_image::threshold( const int th )
+  { threshold_ = threshold_level( th ); }
+
+
+uint8_t Page_image::threshold_level( const Rational & th ) const
   {
-  if( th >= 0 && th <= 1 )
-    threshold_ = ( th * maxval_ ).trunc();
-  else
-    threshold_ = otsu_th( data, *this, maxval_ );
+  if( th >= 0 && th <= 1 ) return ( th * maxval_ ).trunc();
+  return otsu_th( data, *this, maxval_ );
   }
 
 
-void Page_image::threshold( const int th )
+uint8_t Page_image::threshold_level( const int th ) const
   {
-  if( th >= 0 && th <= 255 ) threshold_ = ( th * maxval_ ) / 255;
-  else threshold_ = otsu_th( data, *this, maxval_ );
+  if( th >= 0 && th <= 255 ) return ( th * maxval_ ) / 255;
+  return otsu_th( data, *this, maxval_ );
   }
 
 
@@ -582,26 +555,77 @@ bool Page_image::change_scale( int n )
   }
 
 
+// Returns true if 't' swaps rows and columns.
+bool Page_image::transposes( const Transformation & t )
+  {
+  return ( t.type() == Transformation::rotate90 ||
+           t.type() == Transformation::rotate270 ||
+           t.type() == Transformation::mirror_d1 ||
+           t.type() == Transformation::mirror_d2 );
+  }
+
+
+// Stores the 'rows' source rows 'src[0..rows)', which are the rows
+// 'row0..row0+rows' of the original image, into their final place in
+// 'dst', already sized to the transposed image. 't' must be one of the
+// transformations that swap rows and columns (the transpose, optionally
+// mirrored). The band is walked in tiles of 'tile_cols' columns so that
+// both the source tile and the destination cache lines stay in cache.
+//
+void Page_image::transpose_band( const std::vector< uint8_t > * const src,
+                                 const int row0, const int rows,
+                                 std::vector< std::vector< uint8_t > > & dst,
+                                 const Transformation & t )
+  {
+  const bool flip_tb = ( t.type() == Transformation::rotate90 ||
+                         t.type() == Transformation::mirror_d2 );
+  const bool flip_lr = ( t.type() == Transformation::rotate270 ||
+                         t.type() == Transformation::mirror_d2 );
+  const int width = dst.size(), height = dst[0].size();	// of source
+  const uint8_t * p[band_rows];
+  for( int i = 0; i < rows; ++i ) p[i] = &src[i][0];
+
+  for( int c0 = 0; c0 < width; c0 += tile_cols )
+    {
+    const int c1 = std::min( width, c0 + tile_cols );
+    for( int col = c0; col < c1; ++col )
+      {
+      uint8_t * const d = &dst[flip_tb ? width - 1 - col : col][0];
+      if( !flip_lr )
+        for( int i = 0; i < rows; ++i ) d[row0 + i] = p[i][col];
+      else
+        for( int i = 0; i < rows; ++i ) d[height - 1 - row0 - i] = p[i][col];
+      }
+    }
+  }
+
+
 void Page_image::transform( const Transformation & t )
   {
+  if( transposes( t ) )
+    {
+    const int rows = height(), cols = width();
+    std::vector< std::vector< uint8_t > > new_data( cols );
+    for( int col = 0; col < cols; ++col ) new_data[col].resize( rows );
+    for( int row = 0; row < rows; row += band_rows )
+      {
+      const int n = std::min( (int)band_rows, rows - row );
+      transpose_band( &data[row], row, n, new_data, t );
+      for( int i = 0; i < n; ++i )		// release the source band
+        std::vector< uint8_t >().swap( data[row + i] );
+      }
+    data.swap( new_data );
+    Rectangle::width( rows ); Rectangle::height( cols );
+    return;
+    }
   switch( t.type() )
     {
-    case Transformation::none:
-      break;
-    case Transformation::rotate90:
-      mirror_diagonal( data, *this ); mirror_top_bottom( data ); break;
     case Transformation::rotate180:
       mirror_left_right( data ); mirror_top_bottom( data ); break;
-    case Transformation::rotate270:
-      mirror_diagonal( data, *this ); mirror_left_right( data ); break;
     case Transformation::mirror_lr:
       mirror_left_right( data ); break;
     case Transformation::mirror_tb:
       mirror_top_bottom( data ); break;
-    case Transformation::mirror_d1:
-      mirror_diagonal( data, *this ); break;
-    case Transformation::mirror_d2:
-      mirror_diagonal( data, *this );
-      mirror_left_right( data ); mirror_top_bottom( data ); break;
+    default: break;
     }
   }
@@ -40,12 +40,13 @@ private:
   std::vector< std::vector< uint8_t > > data;	// 256 level greymap
   uint8_t maxval_, threshold_;			// x > threshold == white
 
-  void read_p1( FILE * const f, const bool invert );
-  void read_p4( FILE * const f, const bool invert );
-  void read_p2( FILE * const f, const bool invert );
-  void read_p5( FILE * const f, const bool invert );
-  void read_p3( FILE * const f, const bool invert );
-  void read_p6( FILE * const f, const bool invert );
+  enum { band_rows = 32, tile_cols = 64 };	// transpose block size
+
+  static bool transposes( const Transformation & t );
+  static void transpose_band( const std::vector< uint8_t > * const src,
+                              const int row0, const int rows,
+                              std::vector< std::vector< uint8_t > > & dst,
+                              const Transformation & t );
 
   void left  ( int );		// resize functions declared as private
   void top   ( int );
@@ -55,8 +56,15 @@ private:
   void width ( int );
 
 public:
-  // Creates a Page_image from a pbm, pgm or ppm file
-  Page_image( FILE * const f, const bool invert );
+  // Creates a Page_image from a pbm, pgm or ppm file. Throws
+  // std::bad_alloc if 'max_bytes' > 0 and the image would be larger.
+  // The transformation 't' is applied to the image as it is read.
+  Page_image( FILE * const f, const bool invert,
+              const long long max_bytes = 0,
+              const Transformation & t = Transformation() );
+
+  // Returns true if 'f' seems to contain another image
+  static bool more_images( FILE * const f );
 
   // Creates a Page_image from a OCRAD_Pixmap
   Page_image( const OCRAD_Pixmap & image, const bool invert );
@@ -64,6 +72,10 @@ public:
   // Creates a reduced Page_image
   Page_image( const Page_image & source, const int scale );
 
+  uint8_t get_value( const int row, const int col ) const
+    { return data[row-top()][col-left()]; }
+  const uint8_t * row_data( const int row ) const
+    { return &data[row-top()][0]; }
   bool get_bit( const int row, const int col ) const
     { return data[row-top()][col-left()] <= threshold_; }
   bool get_bit( const int row, const int col, const uint8_t th ) const
@@ -75,6 +87,9 @@ public:
   uint8_t threshold() const { return threshold_; }
   void threshold( const Rational & th );	// 0 <= th <= 1, else auto
   void threshold( const int th );		// 0 <= th <= 255, else auto
+  // Return the threshold that 'threshold( th )' would set
+  uint8_t threshold_level( const Rational & th ) const;
+  uint8_t threshold_level( const int th ) const;
 
   bool cut( const Rational ltwh[4] );
   void draw_mask( const Mask & m );
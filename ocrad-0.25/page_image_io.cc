@@ -19,6 +19,7 @@
 #include <cctype>
 #include <climits>
 #include <cstdio>
+#include <new>
 #include <string>
 #include <vector>
 #include <stdint.h>
@@ -31,9 +32,20 @@
 
 namespace {
 
+// Locks 'f' while an image is being read so that the bytes can be read
+// without locking the stream once per byte, which is slow as soon as
+// the program has started a second thread.
+struct File_lock
+  {
+  FILE * const f;
+  explicit File_lock( FILE * const file ) : f( file ) { flockfile( f ); }
+  ~File_lock() { funlockfile( f ); }
+  };
+
+
 uint8_t pnm_getrawbyte( FILE * const f )
   {
-  int ch = std::fgetc( f );
+  int ch = getc_unlocked( f );
 
   if( ch == EOF )
     throw Page_image::Error( "end-of-file reading pnm file." );
@@ -81,144 +93,116 @@ uint8_t pbm_getbit( FILE * const f )
   throw Page_image::Error( "junk in pbm file where bits should be." );
   }
 
-} // end namespace
 
+// The row readers append one row of 'cols' pixels to 'datarow'.
+// 'maxval' is the maxval read from the file (1 for pbm).
+typedef void (* Row_reader)( FILE * const f, const bool invert,
+                             const int maxval, const int cols,
+                             std::vector< uint8_t > & datarow );
 
-void Page_image::read_p1( FILE * const f, const bool invert )
+void read_p1( FILE * const f, const bool invert, const int, const int cols,
+              std::vector< uint8_t > & datarow )
   {
-  maxval_ = 1; threshold_ = 0;
-  const int rows = height(), cols = width();
   if( !invert )
-    for( int row = 0; row < rows; ++row )
-      for( int col = 0; col < cols; ++col )
-        data[row].push_back( 1 - pbm_getbit( f ) );
+    for( int col = 0; col < cols; ++col )
+      datarow.push_back( 1 - pbm_getbit( f ) );
   else
-    for( int row = 0; row < rows; ++row )
-      for( int col = 0; col < cols; ++col )
-        data[row].push_back( pbm_getbit( f ) );
+    for( int col = 0; col < cols; ++col )
+      datarow.push_back( pbm_getbit( f ) );
   }
 
 
-void Page_image::read_p4( FILE * const f, const bool invert )
+void read_p4( FILE * const f, const bool invert, const int, const int cols,
+              std::vector< uint8_t > & datarow )
   {
-  maxval_ = 1; threshold_ = 0;
-  const int rows = height(), cols = width();
-  if( !invert )
-    for( int row = 0; row < rows; ++row )
-      for( int col = 0; col < cols; )
-        {
-        uint8_t byte = pnm_getrawbyte( f );
-        for( uint8_t mask = 0x80; mask > 0 && col < cols; mask >>= 1, ++col )
-          data[row].push_back( ( byte & mask ) ? 0 : 1 );
-        }
-  else
-    for( int row = 0; row < rows; ++row )
-      for( int col = 0; col < cols; )
-        {
-        uint8_t byte = pnm_getrawbyte( f );
-        for( uint8_t mask = 0x80; mask > 0 && col < cols; mask >>= 1, ++col )
-          data[row].push_back( ( byte & mask ) ? 1 : 0 );
-        }
+  const uint8_t black = invert ? 1 : 0;
+  for( int col = 0; col < cols; )
+    {
+    uint8_t byte = pnm_getrawbyte( f );
+    for( uint8_t mask = 0x80; mask > 0 && col < cols; mask >>= 1, ++col )
+      datarow.push_back( ( byte & mask ) ? black : 1 - black );
+    }
   }
 
 
-void Page_image::read_p2( FILE * const f, const bool invert )
+void read_p2( FILE * const f, const bool invert, const int maxval,
+              const int cols, std::vector< uint8_t > & datarow )
   {
-  const int maxval = pnm_getint( f );
-  if( maxval == 0 ) throw Page_image::Error( "zero maxval in pgm file." );
-  maxval_ = std::min( maxval, 255 );
-  threshold_ = maxval_ / 2;
-  const int rows = height(), cols = width();
-
-  for( int row = 0; row < rows; ++row )
-    for( int col = 0; col < cols; ++col )
-      {
-      int val = pnm_getint( f );
-      if( val > maxval ) throw Page_image::Error( "value > maxval in pgm file." );
-      if( invert ) val = maxval - val;
-      if( maxval > 255 ) { val *= 255; val /= maxval; }
-      data[row].push_back( val );
-      }
+  for( int col = 0; col < cols; ++col )
+    {
+    int val = pnm_getint( f );
+    if( val > maxval ) throw Page_image::Error( "value > maxval in pgm file." );
+    if( invert ) val = maxval - val;
+    if( maxval > 255 ) { val *= 255; val /= maxval; }
+    datarow.push_back( val );
+    }
   }
 
 
-void Page_image::read_p5( FILE * const f, const bool invert )
+void read_p5( FILE * const f, const bool invert, const int maxval,
+              const int cols, std::vector< uint8_t > & datarow )
   {
-  const int maxval = pnm_getint( f );
-  if( maxval == 0 ) throw Page_image::Error( "zero maxval in pgm file." );
-  if( maxval > 255 ) throw Page_image::Error( "maxval > 255 in pgm \"P5\" file." );
-  maxval_ = maxval;
-  threshold_ = maxval_ / 2;
-  const int rows = height(), cols = width();
-
-  for( int row = 0; row < rows; ++row )
-    for( int col = 0; col < cols; ++col )
-      {
-      uint8_t val = pnm_getrawbyte( f );
-      if( val > maxval_ ) throw Page_image::Error( "value > maxval in pgm file." );
-      if( invert ) val = maxval_ - val;
-      data[row].push_back( val );
-      }
+  for( int col = 0; col < cols; ++col )
+    {
+    uint8_t val = pnm_getrawbyte( f );
+    if( val > maxval ) throw Page_image::Error( "value > maxval in pgm file." );
+    if( invert ) val = maxval - val;
+    datarow.push_back( val );
+    }
   }
 
 
-void Page_image::read_p3( FILE * const f, const bool invert )
+void read_p3( FILE * const f, const bool invert, const int maxval,
+              const int cols, std::vector< uint8_t > & datarow )
   {
-  const int maxval = pnm_getint( f );
-  if( maxval == 0 ) throw Page_image::Error( "zero maxval in ppm file." );
-  maxval_ = std::min( maxval, 255 );
-  threshold_ = maxval_ / 2;
-  const int rows = height(), cols = width();
-
-  for( int row = 0; row < rows; ++row )
-    for( int col = 0; col < cols; ++col )
-      {
-      const int r = pnm_getint( f );			// Red value
-      const int g = pnm_getint( f );			// Green value
-      const int b = pnm_getint( f );			// Blue value
-      if( r > maxval || g > maxval || b > maxval )
-        throw Page_image::Error( "value > maxval in ppm file." );
-      int val;
-      if( !invert ) val = std::min( r, std::min( g, b ) );
-      else val = maxval - std::max( r, std::max( g, b ) );
-      if( maxval > 255 ) { val *= 255; val /= maxval; }
-      data[row].push_back( val );
-      }
+  for( int col = 0; col < cols; ++col )
+    {
+    const int r = pnm_getint( f );			// Red value
+    const int g = pnm_getint( f );			// Green value
+    const int b = pnm_getint( f );			// Blue value
+    if( r > maxval || g > maxval || b > maxval )
+      throw Page_image::Error( "value > maxval in ppm file." );
+    int val;
+    if( !invert ) val = std::min( r, std::min( g, b ) );
+    else val = maxval - std::max( r, std::max( g, b ) );
+    if( maxval > 255 ) { val *= 255; val /= maxval; }
+    datarow.push_back( val );
+    }
   }
 
 
-void Page_image::read_p6( FILE * const f, const bool invert )
+void read_p6( FILE * const f, const bool invert, const int maxval,
+              const int cols, std::vector< uint8_t > & datarow )
   {
-  const int maxval = pnm_getint( f );
-  if( maxval == 0 ) throw Page_image::Error( "zero maxval in ppm file." );
-  if( maxval > 255 ) throw Page_image::Error( "maxval > 255 in ppm \"P6\" file." );
-  maxval_ = maxval;
-  threshold_ = maxval_ / 2;
-  const int rows = height(), cols = width();
-
-  for( int row = 0; row < rows; ++row )
-    for( int col = 0; col < cols; ++col )
-      {
-      const uint8_t r = pnm_getrawbyte( f );	// Red value
-      const uint8_t g = pnm_getrawbyte( f );	// Green value
-      const uint8_t b = pnm_getrawbyte( f );	// Blue value
-      if( r > maxval_ || g > maxval_ || b > maxval_ )
-        throw Page_image::Error( "value > maxval in ppm file." );
-      uint8_t val;
-      if( !invert ) val = std::min( r, std::min( g, b ) );
-      else val = maxval_ - std::max( r, std::max( g, b ) );
-      data[row].push_back( val );
-      }
+  for( int col = 0; col < cols; ++col )
+    {
+    const uint8_t r = pnm_getrawbyte( f );	// Red value
+    const uint8_t g = pnm_getrawbyte( f );	// Green value
+    const uint8_t b = pnm_getrawbyte( f );	// Blue value
+    if( r > maxval || g > maxval || b > maxval )
+      throw Page_image::Error( "value > maxval in ppm file." );
+    uint8_t val;
+    if( !invert ) val = std::min( r, std::min( g, b ) );
+    else val = maxval - std::max( r, std::max( g, b ) );
+    datarow.push_back( val );
+    }
   }
 
+} // end namespace
+
 
 // Creates a Page_image from a pbm, pgm or ppm file
 // "P1" (pbm), "P4" (pbm RAWBITS), "P2" (pgm), "P5" (pgm RAWBITS),
 // "P3" (ppm), "P6" (ppm RAWBITS) file formats are recognized.
+// If 't' swaps rows and columns, it is applied while decoding; each band
+// of rows read is transposed into the final image, so that the image is
+// never stored twice.
 //
-Page_image::Page_image( FILE * const f, const bool invert )
+Page_image::Page_image( FILE * const f, const bool invert,
+                        const long long max_bytes, const Transformation & t )
   : Rectangle( 0, 0, 0, 0 )
   {
+  const File_lock lock( f );
   unsigned char filetype = 0;
 
   if( pnm_getrawbyte( f ) == 'P' )
@@ -240,20 +224,59 @@ Page_image::Page_image( FILE * const f, const bool invert )
     throw Error( "image too small. Minimum size is 3x3." );
   if( INT_MAX / width() < height() )
     throw Error( "image too big. 'int' will overflow." );
+  if( max_bytes > 0 && (long long)width() * height() > max_bytes )
+    throw std::bad_alloc();
   }
 
-  data.resize( height() );
-  for( unsigned row = 0; row < data.size(); ++row )
-    data[row].reserve( width() );
+  int maxval = 1;
+  if( filetype == '1' || filetype == '4' ) { maxval_ = 1; threshold_ = 0; }
+  else
+    {
+    const bool pgm = ( filetype == '2' || filetype == '5' );
+    maxval = pnm_getint( f );
+    if( maxval == 0 )
+      throw Error( pgm ? "zero maxval in pgm file." : "zero maxval in ppm file." );
+    if( maxval > 255 && filetype == '5' )
+      throw Error( "maxval > 255 in pgm \"P5\" file." );
+    if( maxval > 255 && filetype == '6' )
+      throw Error( "maxval > 255 in ppm \"P6\" file." );
+    maxval_ = std::min( maxval, 255 );
+    threshold_ = maxval_ / 2;
+    }
 
+  Row_reader read_row = 0;
   switch( filetype )
     {
-    case '1': read_p1( f, invert ); break;
-    case '4': read_p4( f, invert ); break;
-    case '2': read_p2( f, invert ); break;
-    case '5': read_p5( f, invert ); break;
-    case '3': read_p3( f, invert ); break;
-    case '6': read_p6( f, invert ); break;
+    case '1': read_row = read_p1; break;
+    case '4': read_row = read_p4; break;
+    case '2': read_row = read_p2; break;
+    case '5': read_row = read_p5; break;
+    case '3': read_row = read_p3; break;
+    case '6': read_row = read_p6; break;
+    }
+
+  const int rows = height(), cols = width();
+  if( !transposes( t ) )
+    {
+    data.resize( rows );
+    for( int row = 0; row < rows; ++row )
+      { data[row].reserve( cols ); read_row( f, invert, maxval, cols, data[row] ); }
+    transform( t );
+    }
+  else
+    {
+    std::vector< std::vector< uint8_t > > band( band_rows );
+    for( int i = 0; i < band_rows; ++i ) band[i].reserve( cols );
+    data.resize( cols );
+    for( int col = 0; col < cols; ++col ) data[col].resize( rows );
+    for( int row = 0; row < rows; row += band_rows )
+      {
+      const int n = std::min( (int)band_rows, rows - row );
+      for( int i = 0; i < n; ++i )
+        { band[i].clear(); read_row( f, invert, maxval, cols, band[i] ); }
+      transpose_band( &band[0], row, n, data, t );
+      }
+    Rectangle::width( rows ); Rectangle::height( cols );
     }
 
   if( verbosity >= 1 )
@@ -264,6 +287,20 @@ Page_image::Page_image( FILE * const f, const bool invert )
   }
 
 
+// Skips the whitespace and NUL padding following an image in a
+// multi-image pnm stream. Returns true if 'f' contains more data, which
+// should be the next image.
+//
+bool Page_image::more_images( FILE * const f )
+  {
+  int ch;
+  do ch = std::fgetc( f ); while( ch == 0 || std::isspace( ch ) );
+  if( ch == EOF ) return false;
+  std::ungetc( ch, f );
+  return true;
+  }
+
+
 bool Page_image::save( FILE * const f, const char filetype ) const
   {
   if( filetype < '1' || filetype > '6' ) return false;
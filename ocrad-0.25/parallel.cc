@@ -0,0 +1,95 @@
+/*  GNU Ocrad - Optical Character Recognition program
+    Copyright (C) 2003-2015 Antonio Diaz Diaz.
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 2 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include <algorithm>
+#include <cstdio>
+#include <vector>
+#include <pthread.h>
+#include <unistd.h>
+
+#include "common.h"
+#include "parallel.h"
+
+
+namespace {
+
+struct Job_queue
+  {
+  void (* job)( void * const arg, const int i );
+  void * arg;
+  int jobs;
+  int next;			// next job to be handed out
+  pthread_mutex_t mutex;
+  };
+
+
+void * worker( void * const p )
+  {
+  Job_queue & queue = *(Job_queue *)p;
+  while( true )
+    {
+    int i;
+    if( pthread_mutex_lock( &queue.mutex ) != 0 )
+      Ocrad::internal_error( "can't lock job queue." );
+    i = queue.next;
+    if( i < queue.jobs ) ++queue.next;
+    pthread_mutex_unlock( &queue.mutex );
+    if( i >= queue.jobs ) break;
+    queue.job( queue.arg, i );
+    }
+  return 0;
+  }
+
+} // end namespace
+
+
+int Ocrad::processors()
+  {
+#ifdef _SC_NPROCESSORS_ONLN
+  const long n = sysconf( _SC_NPROCESSORS_ONLN );
+  if( n > 1 ) return std::min( n, 1024L );
+#endif
+  return 1;
+  }
+
+
+void Ocrad::parallel_run( void (* const job)( void * const arg, const int i ),
+                          void * const arg, const int jobs, int threads )
+  {
+  if( threads > jobs ) threads = jobs;
+  if( threads <= 1 )
+    { for( int i = 0; i < jobs; ++i ) job( arg, i ); return; }
+
+  Job_queue queue;
+  queue.job = job; queue.arg = arg; queue.jobs = jobs; queue.next = 0;
+  if( pthread_mutex_init( &queue.mutex, 0 ) != 0 )
+    { for( int i = 0; i < jobs; ++i ) job( arg, i ); return; }
+
+  std::vector< pthread_t > workers;
+  workers.reserve( threads - 1 );
+  for( int i = 1; i < threads; ++i )
+    {
+    pthread_t id;
+    if( pthread_create( &id, 0, worker, &queue ) != 0 ) break;
+    workers.push_back( id );
+    }
+  worker( &queue );			// the calling thread also works
+  for( unsigned i = 0; i < workers.size(); ++i )
+    if( pthread_join( workers[i], 0 ) != 0 )
+      Ocrad::internal_error( "can't join worker thread." );
+  pthread_mutex_destroy( &queue.mutex );
+  }
@@ -0,0 +1,31 @@
+/*  GNU Ocrad - Optical Character Recognition program
+    Copyright (C) 2003-2015 Antonio Diaz Diaz.
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 2 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+namespace Ocrad {
+
+// Returns the number of processors online, or 1 if unknown.
+int processors();
+
+// Calls 'job( arg, i )' for every 'i' in [0, jobs), using up to
+// 'threads' threads (the calling thread included). Jobs are handed out
+// in increasing order of 'i'. If no threads can be created, all the
+// jobs are run by the calling thread.
+// 'job' must not throw; exceptions can't cross thread boundaries.
+void parallel_run( void (* const job)( void * const arg, const int i ),
+                   void * const arg, const int jobs, const int threads );
+
+} // end namespace Ocrad
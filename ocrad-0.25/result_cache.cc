@@ -0,0 +1,197 @@
+/*  GNU Ocrad - Optical Character Recognition program
+    Copyright (C) 2003-2015 Antonio Diaz Diaz.
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 2 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <new>
+#include <string>
+#include <vector>
+#include <stdint.h>
+#include <dirent.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <utime.h>
+#if defined(__MSVCRT__) || defined(__OS2__) || defined(_MSC_VER)
+#include <io.h>
+#define mkdir( name, mode ) _mkdir( name )
+#endif
+
+#include "ocradlib.h"
+#include "common.h"
+#include "rectangle.h"
+#include "user_filter.h"
+#include "page_image.h"
+#include "textpage.h"
+#include "result_cache.h"
+
+
+namespace {
+
+const int format_version = 1;		// of the entries
+
+// 64-bit FNV-1a, taking 8 bytes at a time. The shift folds the high
+// bits of each product back into the low ones.
+class Hash
+  {
+  uint64_t h;
+
+public:
+  Hash() : h( 14695981039346656037ULL ) {}
+
+  void add( const uint8_t * const p, const int size )
+    {
+    int i = 0;
+    for( ; i + 8 <= size; i += 8 )
+      {
+      uint64_t w; std::memcpy( &w, p + i, 8 );
+      h = ( h ^ w ) * 1099511628211ULL; h ^= h >> 29;
+      }
+    for( ; i < size; ++i ) { h = ( h ^ p[i] ) * 1099511628211ULL; h ^= h >> 29; }
+    }
+  void add( const long long n )
+    { add( (const uint8_t *)&n, sizeof n ); }
+  void add( const char * const s )
+    { add( (const uint8_t *)s, std::strlen( s ) + 1 ); }
+
+  std::string hex() const
+    {
+    char buf[17];
+    std::snprintf( buf, sizeof buf, "%016llx", (unsigned long long)h );
+    return buf;
+    }
+  };
+
+
+struct Entry
+  {
+  std::string name;
+  long long size;
+  long mtime;
+  Entry( const std::string & n, const long long s, const long t )
+    : name( n ), size( s ), mtime( t ) {}
+  bool operator<( const Entry & e ) const { return mtime < e.mtime; }
+  };
+
+} // end namespace
+
+
+// The version of the library is part of the key, so that a new version
+// doesn't return the results of the previous one. User filters are
+// hashed through the codes they map in the Basic Multilingual Plane.
+std::string Result_cache::key( const Page_image & page_image,
+                               const int threshold, const Control & control,
+                               const bool layout )
+  {
+  Hash hash;
+  hash.add( OCRAD_version_string );
+  hash.add( format_version );
+  hash.add( page_image.width() );
+  hash.add( page_image.height() );
+  hash.add( page_image.maxval() );
+  hash.add( threshold );
+  for( int row = page_image.top(); row <= page_image.bottom(); ++row )
+    hash.add( page_image.row_data( row ), page_image.width() );
+
+  hash.add( control.charset.enabled( Charset::ascii ) +
+            2 * control.charset.enabled( Charset::iso_8859_9 ) +
+            4 * control.charset.enabled( Charset::iso_8859_15 ) );
+  for( unsigned i = 0; i < control.filters.size(); ++i )
+    {
+    const Filter & filter = control.filters[i];
+    hash.add( filter.type );
+    if( filter.type != Filter::user ) continue;
+    const User_filter & user_filter = *filter.user_filterp;
+    hash.add( user_filter.discard() + 2 * user_filter.mark() );
+    for( int code = 0; code < 0x10000; ++code )
+      hash.add( user_filter.get_new_code( code ) );
+    }
+  hash.add( control.quality );
+  hash.add( control.despeckle );
+  hash.add( control.window );
+  hash.add( control.memory_limit );
+  hash.add( control.coarse_layout );
+  hash.add( layout );
+  return hash.hex();
+  }
+
+
+// A hit refreshes the time of the entry, which is used to find the
+// least recently used ones. Entries that can't be read are deleted.
+Textpage * Result_cache::find( const std::string & key,
+                               const char * const filename ) const
+  {
+  const std::string name = path( key );
+  FILE * const f = std::fopen( name.c_str(), "rb" );
+  if( !f ) return 0;
+  Textpage * textpage = 0;
+  try { textpage = Textpage::load( f, filename ); }
+  catch( std::bad_alloc ) { textpage = 0; }
+  std::fclose( f );
+  if( textpage ) utime( name.c_str(), 0 );
+  else std::remove( name.c_str() );
+  return textpage;
+  }
+
+
+// The entry is written to a temporary file and then renamed, so that
+// other processes sharing the directory never read a partial entry.
+bool Result_cache::store( const std::string & key, const Textpage & textpage ) const
+  {
+  mkdir( dir.c_str(), 0755 );			// may already exist
+  const std::string name = path( key );
+  char suffix[32];
+  std::snprintf( suffix, sizeof suffix, ".%ld.tmp", (long)getpid() );
+  const std::string tmp_name = name + suffix;
+  FILE * const f = std::fopen( tmp_name.c_str(), "wb" );
+  if( !f ) return false;
+  textpage.save( f );
+  const bool error = std::ferror( f );
+  if( std::fclose( f ) != 0 || error ||
+      std::rename( tmp_name.c_str(), name.c_str() ) != 0 )
+    { std::remove( tmp_name.c_str() ); return false; }
+  if( max_bytes > 0 ) evict();
+  return true;
+  }
+
+
+// Deletes the least recently used entries until they take 90% or less of
+// 'max_bytes'.
+void Result_cache::evict() const
+  {
+  DIR * const dp = opendir( dir.c_str() );
+  if( !dp ) return;
+  std::vector< Entry > entries;
+  long long total = 0;
+  const struct dirent * ep;
+  while( ( ep = readdir( dp ) ) != 0 )
+    {
+    const std::string name( ep->d_name );
+    const unsigned len = name.size();
+    struct stat st;
+    if( len <= 4 || name.compare( len - 4, 4, ".ocr" ) != 0 ||
+        stat( ( dir + '/' + name ).c_str(), &st ) != 0 ) continue;
+    entries.push_back( Entry( name, st.st_size, st.st_mtime ) );
+    total += st.st_size;
+    }
+  closedir( dp );
+  if( total <= max_bytes ) return;
+  std::sort( entries.begin(), entries.end() );
+  for( unsigned i = 0; i < entries.size() && total > max_bytes / 10 * 9; ++i )
+    if( std::remove( ( dir + '/' + entries[i].name ).c_str() ) == 0 )
+      total -= entries[i].size;
+  }
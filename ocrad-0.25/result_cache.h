@@ -0,0 +1,51 @@
+/*  GNU Ocrad - Optical Character Recognition program
+    Copyright (C) 2003-2015 Antonio Diaz Diaz.
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 2 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+class Page_image;
+class Textpage;
+
+// On-disk cache of recognition results, for archives that recognize the
+// same pages again. Entries are files in directory 'dir', named after a
+// hash of the image as it is going to be recognized (after cut,
+// transformation and scaling) and of every setting that affects the
+// result. When the entries exceed 'max_bytes', the least recently used
+// ones are deleted.
+//
+class Result_cache
+  {
+public:
+  enum { default_size = 256, max_size = 1 << 20 };	// MiB
+
+private:
+  const std::string dir;
+  const long long max_bytes;
+
+  std::string path( const std::string & key ) const
+    { return dir + '/' + key + ".ocr"; }
+  void evict() const;
+
+public:
+  Result_cache( const char * const dirname, const long long max )
+    : dir( dirname ), max_bytes( max ) {}
+
+  static std::string key( const Page_image & page_image, const int threshold,
+                          const Control & control, const bool layout );
+
+  // Returns the results stored for 'key', or 0 if none
+  Textpage * find( const std::string & key, const char * const filename ) const;
+  bool store( const std::string & key, const Textpage & textpage ) const;
+  };
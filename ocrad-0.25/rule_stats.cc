@@ -0,0 +1,114 @@
+/*  GNU Ocrad - Optical Character Recognition program
+    Copyright (C) 2003-2015 Antonio Diaz Diaz.
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 2 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include <cstdio>
+#include <map>
+#include <vector>
+#include <pthread.h>
+
+#include "common.h"
+#include "rule_stats.h"
+
+
+namespace {
+
+const char * const test_name[Rule_stats::tests] =
+  { "test_235Esz", "test_49ARegpq", "test_4ADQao", "test_6abd",
+    "test_EFIJLlT", "test_c", "test_frst", "test_G", "test_HKMNUuvwYy",
+    "test_hknwx", "test_s_cedilla", "test_comma", "test_easy", "test_line",
+    "test_solid", "test_misc" };
+
+struct Counter
+  {
+  long calls;
+  long long time;
+  Counter() : calls( 0 ), time( 0 ) {}
+  };
+
+std::map< int, Counter > counters[Rule_stats::tests];	// code -> Counter
+pthread_mutex_t mutex = PTHREAD_MUTEX_INITIALIZER;	// guards 'counters'
+
+
+class Lock
+  {
+  Lock( const Lock & );				// declared as private
+  void operator=( const Lock & );		// declared as private
+public:
+  Lock()
+    { if( pthread_mutex_lock( &mutex ) != 0 )
+        Ocrad::internal_error( "can't lock rule stats." ); }
+  ~Lock() { pthread_mutex_unlock( &mutex ); }
+  };
+
+
+void print_code( FILE * const f, const int code )
+  {
+  if( code == 0 ) std::fputs( "  rejected", f );
+  else if( code > 32 && code < 127 ) std::fprintf( f, "  '%c'     ", code );
+  else std::fprintf( f, "  %-8d", code );
+  }
+
+} // end namespace
+
+
+bool Rule_stats::enabled = false;
+
+
+void Rule_stats::record( const Test test, const int code,
+                         const long long time )
+  {
+  const Lock lock;
+  Counter & c = counters[test][code];
+  ++c.calls; c.time += time;
+  }
+
+
+void Rule_stats::reset()
+  {
+  const Lock lock;
+  for( int i = 0; i < tests; ++i ) counters[i].clear();
+  }
+
+
+// Prints a line with the totals of each test called at least once,
+// followed by a line for each code returned by it.
+void Rule_stats::print( FILE * const f )
+  {
+  const Lock lock;
+  std::fputs( "test              calls    accepts   time (us)\n", f );
+  for( int i = 0; i < tests; ++i )
+    {
+    if( counters[i].empty() ) continue;
+    long calls = 0, accepts = 0;
+    long long time = 0;
+    for( std::map< int, Counter >::const_iterator it = counters[i].begin();
+         it != counters[i].end(); ++it )
+      {
+      calls += it->second.calls; time += it->second.time;
+      if( it->first != 0 ) accepts += it->second.calls;
+      }
+    std::fprintf( f, "%-16s %6ld %10ld %11lld\n",
+                  test_name[i], calls, accepts, time / 1000 );
+    for( std::map< int, Counter >::const_iterator it = counters[i].begin();
+         it != counters[i].end(); ++it )
+      {
+      print_code( f, it->first );
+      std::fprintf( f, "%13ld %10s %11lld\n",
+                    it->second.calls, "", it->second.time / 1000 );
+      }
+    }
+  }
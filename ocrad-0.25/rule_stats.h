@@ -0,0 +1,50 @@
+/*  GNU Ocrad - Optical Character Recognition program
+    Copyright (C) 2003-2015 Antonio Diaz Diaz.
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 2 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+// Opt-in counters of the tests of class Features. For every test and
+// every code returned by it (0 = rejected), they record the number of
+// calls and the time spent in them. The time of a test includes the
+// time of the tests it calls. When disabled, the only cost is a test of
+// 'enabled' per call. The counters are shared by all the descriptors
+// and threads, and are updated under a mutex.
+//
+namespace Rule_stats {
+
+enum Test { t235Esz, t49ARegpq, t4ADQao, t6abd, tEFIJLlT, tc, tfrst, tG,
+            tHKMNUuvwYy, thknwx, ts_cedilla, tcomma, teasy, tline, tsolid,
+            tmisc, tests };
+
+extern bool enabled;
+
+void record( const Test test, const int code, const long long time );
+void reset();
+void print( FILE * const f );
+
+// Times one call to a test. Create it before calling the test and pass
+// the code returned by the test through operator().
+class Probe
+  {
+  const Test test;
+  const long long start;
+
+public:
+  explicit Probe( const Test t ) : test( t ), start( enabled ? Ocrad::nanoseconds() : 0 ) {}
+  int operator()( const int code ) const
+    { if( enabled ) record( test, code, Ocrad::nanoseconds() - start ); return code; }
+  };
+
+} // end namespace Rule_stats
@@ -38,6 +38,14 @@ if [ $? = 1 ] ; then printf . ; else printf - ; fail=1 ; fi
 if [ $? = 1 ] ; then printf . ; else printf - ; fail=1 ; fi
 "${OCRAD}" -q -u 1,1,1,1 ${in} > /dev/null
 if [ $? = 1 ] ; then printf . ; else printf - ; fail=1 ; fi
+"${OCRAD}" -q --quality=best ${in} > /dev/null
+if [ $? = 1 ] ; then printf . ; else printf - ; fail=1 ; fi
+"${OCRAD}" -q --threshold-sweep=0.5,2 ${in} > /dev/null
+if [ $? = 1 ] ; then printf . ; else printf - ; fail=1 ; fi
+"${OCRAD}" -q --adaptive=2000 ${in} > /dev/null
+if [ $? = 1 ] ; then printf . ; else printf - ; fail=1 ; fi
+"${OCRAD}" -q --cache-size=-1 ${in} > /dev/null
+if [ $? = 1 ] ; then printf . ; else printf - ; fail=1 ; fi
 
 "${OCRAD}" ${in} > out || fail=1
 cmp ${txt} out || fail=1
@@ -51,6 +59,79 @@ printf .
 "${OCRAD}" -F utf8 < ${in} > out || fail=1
 cmp ${utxt} out || fail=1
 printf .
+"${OCRAD}" --quality=fast ${in} > out || fail=1
+sed -e "s/^!\"#/!''#/" ${txt} > txtf || framework_failure
+cmp txtf out || fail=1
+printf .
+"${OCRAD}" --threshold-sweep=0.3,auto,70% ${in} > out || fail=1
+cmp ${txt} out || fail=1
+printf .
+"${OCRAD}" -s auto ${in} > out || fail=1
+cmp ${txt} out || fail=1
+printf .
+"${OCRAD}" -s 3 ${in} > txt3 || fail=1
+"${OCRAD}" -s 3 --coarse-layout ${in} > out || fail=1
+cmp txt3 out || fail=1
+printf .
+rm -f txt3
+"${OCRAD}" --adaptive ${in} > out || fail=1
+cmp ${txt} out || fail=1
+printf .
+# test.pbm as a greymap lit unevenly, from white on the left to dark grey
+# on the right; the global threshold loses the right side
+size=`sed -n 2p ${in}`
+od -An -v -tu1 -j `head -n 2 ${in} | wc -c` ${in} | awk -v size="${size}" '
+BEGIN { split( size, a, " " ) ; w = a[1] ; h = a[2]
+        print "P2" ; print w, h ; print 255 ; x = 0 }
+{ for( i = 1; i <= NF; ++i )
+    for( bit = 128; bit >= 1; bit /= 2 ) {
+      if( x < w ) {
+        light = 255 - int( 200 * x / w )
+        if( int( $i / bit ) % 2 ) light = int( light * 0.35 )
+        print light }
+      if( ++x >= w + ( 8 - w % 8 ) % 8 ) x = 0 } }' > grey.pgm || framework_failure
+"${OCRAD}" grey.pgm > out || fail=1
+if cmp -s ${txt} out ; then fail=1 ; fi
+"${OCRAD}" --adaptive grey.pgm > out || fail=1
+cmp ${txt} out || fail=1
+printf .
+rm -f grey.pgm
+# test.pbm with isolated specks of 3x3 pixels on a grid over the white
+# areas, which spoil the plain recognition
+od -An -v -tu1 -j `head -n 2 ${in} | wc -c` ${in} | awk -v size="${size}" '
+BEGIN { split( size, a, " " ) ; w = a[1] ; h = a[2] ; n = 0
+        wb = w + ( 8 - w % 8 ) % 8 }		# width padded to bytes
+{ for( i = 1; i <= NF; ++i )
+    for( bit = 128; bit >= 1; bit /= 2 )
+      { if( n % wb < w ) p[int(n/wb),n%wb] = int( $i / bit ) % 2 ; ++n } }
+END { print "P1" ; print w, h
+      for( y = 0; y < h; ++y )
+        for( x = 0; x < w; ++x ) {
+          v = p[y,x] ; x0 = x - x % 9 ; y0 = y - y % 7
+          if( !v && x - x0 < 3 && y - y0 < 3 ) {
+            v = 1
+            for( dy = -1; dy <= 3; ++dy ) for( dx = -1; dx <= 3; ++dx )
+              if( p[y0+dy,x0+dx] ) v = 0 }
+          print v } }' > speck.pbm || framework_failure
+"${OCRAD}" speck.pbm > out || fail=1
+if cmp -s ${txt} out ; then fail=1 ; fi
+"${OCRAD}" --despeckle=9 speck.pbm > out || fail=1
+cmp ${txt} out || fail=1
+printf .
+rm -f speck.pbm
+"${OCRAD}" --memory-limit=1 ${in} > out || fail=1
+cmp ${txt} out || fail=1
+printf .
+"${OCRAD}" ${in} > out || fail=1
+"${OCRAD}" -n 4 ${in} > out4 || fail=1
+cmp out out4 || fail=1
+printf .
+"${OCRAD}" -C -s 4 ${in} > in4 || fail=1
+"${OCRAD}" -s -2 in4 > txt4 || fail=1
+"${OCRAD}" -s auto in4 > out || fail=1
+cmp txt4 out || fail=1
+printf .
+rm -f in4 txt4
 
 "${OCRAD}" -E ${ouf} ${in} > out || fail=1
 cmp ${txt} out || fail=1
@@ -58,6 +139,19 @@ printf .
 "${OCRAD}" -E ${ouf} -F utf8 ${in} > out || fail=1
 cmp ${utxt} out || fail=1
 printf .
+"${OCRAD}" --threshold-sweep=0.3,0.5 -E ${ouf} ${in} > out || fail=1
+cmp ${txt} out || fail=1
+printf .
+"${OCRADCHECK}" ${in} -E ${ouf} > out || fail=1
+cmp ${txt} out || fail=1
+printf .
+"${OCRAD}" -E ${ouf} --cache=cachedir -F utf8 ${in} > out || fail=1
+cmp ${utxt} out || fail=1
+printf .
+"${OCRAD}" -E ${ouf} --cache=cachedir -F utf8 ${in} > out || fail=1
+cmp ${utxt} out || fail=1
+printf .
+rm -rf cachedir
 
 "${OCRAD}" -u 0,0,1,1 ${in} > out
 cmp ${txt} out || fail=1
@@ -82,7 +176,30 @@ printf .
 "${OCRAD}" -F utf8 < in2 > out || fail=1
 cmp utxt2 out || fail=1
 printf .
-rm -f in2 txt2 utxt2
+"${OCRAD}" in2 > out || fail=1
+cmp txt2 out || fail=1
+printf .
+"${OCRAD}" --incremental in2 > out || fail=1
+cmp txt2 out || fail=1
+printf .
+"${OCRAD}" --cache=cachedir in2 > out || fail=1
+cmp txt2 out || fail=1
+printf .
+"${OCRAD}" --cache=cachedir in2 > out || fail=1
+cmp txt2 out || fail=1
+printf .
+rm -rf cachedir
+"${OCRADCHECK}" in2 > out || fail=1
+cmp txt2 out || fail=1
+printf .
+printf "\f" | cat ${txt} - ${txt} > txt2 || framework_failure
+"${OCRAD}" -p in2 > out || fail=1
+cmp txt2 out || fail=1
+printf .
+"${OCRAD}" -n 4 -p in2 > out4 || fail=1
+cmp out out4 || fail=1
+printf .
+rm -f in2 txt2 utxt2 out4
 
 test_chars()
 	{
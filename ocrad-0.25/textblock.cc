@@ -31,9 +31,11 @@
 #include "bitmap.h"
 #include "blob.h"
 #include "character.h"
+#include "frame_cache.h"
 #include "page_image.h"
 #include "textline.h"
 #include "textblock.h"
+#include "trace.h"
 
 
 namespace {
@@ -49,19 +51,38 @@ void delete_line( std::vector< Textline * > & textlinep_vector, int i )
   }
 
 
+// Sets 'min_left[i]' to the minimum left of characters [i, end) of 'line'.
+void set_min_left( const Textline & line, std::vector< int > & min_left )
+  {
+  min_left.resize( line.characters() );
+  for( int i = line.characters() - 1; i >= 0; --i )
+    {
+    min_left[i] = line.character( i ).left();
+    if( i + 1 < line.characters() )
+      min_left[i] = std::min( min_left[i], min_left[i+1] );
+    }
+  }
+
+
 // Build the vertical composite characters.
+// Characters are in order of hcenter, so the search for characters
+// overlapping c1 stops as soon as all the remaining characters begin to
+// the right of c1.
 //
 void join_characters( std::vector< Textline * > & tlpv )
   {
+  std::vector< int > min_left;		// min left of characters [i, end)
   for( unsigned current_line = 0; current_line < tlpv.size(); ++current_line )
     {
     Textline & line = *tlpv[current_line];
+    set_min_left( line, min_left );
     for( int i = 0 ; i < line.characters() - 1; )
       {
       Character & c1 = line.character( i );
       bool joined = false;
       for( int j = i + 1 ; j < line.characters(); ++j )
         {
+        if( min_left[j] > c1.right() ) break;
         Character & c2 = line.character( j );
         if( !c1.h_overlaps( c2 ) ) continue;
         Character *cup, *cdn;
@@ -79,6 +100,7 @@ void join_characters( std::vector< Textline * > & tlpv )
           else if( cdn == &c2 ) { c2.join( c1 ); k = i; }
           else { c1.join( c2 ); k = j; }
           line.delete_character( k );
+          set_min_left( line, min_left );
           joined = true; break;
           }
         }
@@ -90,22 +112,24 @@ void join_characters( std::vector< Textline * > & tlpv )
 } // end namespace
 
 
-void Textblock::apply_filters( const Control & control )
+void Textblock::filter_lines( const Control & control )
   {
   if( textlines() <= 0 ) return;
+  const bool thorough = ( control.quality >= Control::thorough );
   for( unsigned f = 0; f < control.filters.size(); ++f )
     {
     if( control.filters[f].user_filterp )
       {
       for( int i = 0; i < textlines(); ++i )
-        tlpv[i]->apply_user_filter( *control.filters[f].user_filterp );
+        tlpv[i]->apply_user_filter( *control.filters[f].user_filterp,
+                                    thorough );
       continue;
       }
     const Filter::Type filter = control.filters[f].type;
     if( filter != Filter::text_block )
       {
       for( int i = 0; i < textlines(); ++i )
-        tlpv[i]->apply_filter( filter );
+        tlpv[i]->apply_filter( filter, thorough );
       continue;
       }
     int l = right(), t = bottom(), r = left(), b = top();
@@ -224,12 +248,21 @@ Textblock::Textblock( const Rectangle & page, const Rectangle & block,
     current_line = std::max( min_line, current_line - 2 );
     while( true )
       {
+      // find the nearest characters not overlapping b at each side
+      const Textline & line = *tlpv[current_line];
       const Character *cl = 0, *cr = 0;
-      for( int j = tlpv[current_line]->characters() - 1; j >= 0; --j )
+      const int k = line.upper_index( b.hcenter() );
+      for( int j = k - 1; j >= 0; --j )
         {
-        const Character & cj = tlpv[current_line]->character( j );
+        const Character & cj = line.character( j );
         if( !b.includes_hcenter( cj ) && !cj.includes_hcenter( b ) )
-          { if( b.h_precedes( cj ) ) cr = &cj; else { cl = &cj; break; } }
+          { cl = &cj; break; }
+        }
+      for( int j = k; j < line.characters(); ++j )
+        {
+        const Character & cj = line.character( j );
+        if( !b.includes_hcenter( cj ) && !cj.includes_hcenter( b ) )
+          { cr = &cj; break; }
         }
       if( ( cl && ( cl->includes_vcenter( b ) || b.includes_vcenter( *cl ) ) ) ||
           ( cr && ( cr->includes_vcenter( b ) || b.includes_vcenter( *cr ) ) ) )
@@ -410,24 +443,46 @@ Textblock::Textblock( const Rectangle & page, const Rectangle & block,
   }
 
 
+Textblock::Textblock( const Textblock & tb )
+  : Rectangle( tb )
+  {
+  tlpv.reserve( tb.tlpv.size() );
+  for( unsigned i = 0; i < tb.tlpv.size(); ++i )
+    tlpv.push_back( new Textline( *tb.tlpv[i] ) );
+  }
+
+
 Textblock::~Textblock()
   {
   for( int i = textlines() - 1; i >= 0; --i ) delete tlpv[i];
   }
 
 
-void Textblock::recognize( const Control & control )
+void Textblock::recognize( const Control & control, Frame_cache * const cache )
   {
   // Recognize characters.
   for( int i = 0; i < textlines(); ++i )
     {
+    Frame_cache::Key key;
+    if( cache && cache->restore( *tlpv[i], key ) ) continue;
     // First pass. Recognize the easy characters.
+    Trace::Span pass1( "recognize1", i );
     tlpv[i]->recognize1( control.charset );
+    pass1.end();
     // Second pass. Use context to clear up ambiguities.
-    tlpv[i]->recognize2( control.charset );
+    Trace::Span pass2( "recognize2", i );
+    tlpv[i]->recognize2( control.charset, control.quality >= Control::thorough );
+    pass2.end();
+    if( cache ) cache->store( key, *tlpv[i] );
     }
+  }
 
-  apply_filters( control );
+
+void Textblock::apply_filters( const Control & control )
+  {
+  Trace::Span filters( "apply_filters" );
+  filter_lines( control );
+  filters.end();
 
   // Remove unrecognized lines.
   for( int i = textlines() - 1; i >= 0; --i )
@@ -466,6 +521,8 @@ void Textblock::recognize( const Control & control )
           { insert_line( tlpv, ++i ); vdistance -= min_vdistance; }
         }
     }
+
+  for( int i = 0; i < textlines(); ++i ) tlpv[i]->set_table();
   }
 
 
@@ -521,6 +578,29 @@ void Textblock::xprint( const Control & control ) const
   }
 
 
+void Textblock::save( FILE * const f ) const
+  {
+  std::fprintf( f, "block %d %d %d %d %d\n",
+                left(), top(), right(), bottom(), textlines() );
+  for( int i = 0; i < textlines(); ++i ) tlpv[i]->save( f );
+  }
+
+
+Textblock * Textblock::load( FILE * const f )
+  {
+  int l, t, r, b, lines;
+  if( std::fscanf( f, " block %d %d %d %d %d", &l, &t, &r, &b, &lines ) != 5 ||
+      l > r || t > b || lines < 0 ) return 0;
+  Textblock * const tbp = new Textblock( Rectangle( l, t, r, b ) );
+  for( int i = 0; i < lines; ++i )
+    {
+    tbp->tlpv.push_back( new Textline );
+    if( !tbp->tlpv.back()->load( f ) ) { delete tbp; return 0; }
+    }
+  return tbp;
+  }
+
+
 void Textblock::cmark( Page_image & page_image ) const
   {
   for( int i = 0; i < textlines(); ++i ) tlpv[i]->cmark( page_image );
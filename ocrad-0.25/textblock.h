@@ -15,20 +15,29 @@
     along with this program.  If not, see <http://www.gnu.org/licenses/>.
 */
 
+class Frame_cache;
+
 class Textblock : public Rectangle
   {
   mutable std::vector< Textline * > tlpv;
 
-  Textblock( const Textblock & );		// declared as private
   void operator=( const Textblock & );		// declared as private
+  explicit Textblock( const Rectangle & re ) : Rectangle( re ) {}
 
-  void apply_filters( const Control & control );
+  void filter_lines( const Control & control );
 
 public:
   Textblock( const Rectangle & page, const Rectangle & block,
              std::vector< Blob * > & blobp_vector );
+  Textblock( const Textblock & tb );
   ~Textblock();
-  void recognize( const Control & control );
+  // Recognizes the characters. If 'cache' is not null, reuses from it
+  // the lines already recognized.
+  void recognize( const Control & control, Frame_cache * const cache = 0 );
+  // Applies the filters of 'control' to the characters recognized,
+  // removes the lines left without text, adds the blank lines and sets
+  // the tables of results of the lines.
+  void apply_filters( const Control & control );
 
   const Textline & textline( const int i ) const;
   int textlines() const { return tlpv.size(); }
@@ -39,4 +48,7 @@ public:
   void xprint( const Control & control ) const;
   void cmark( Page_image & page_image ) const;
   void lmark( Page_image & page_image ) const;
+
+  void save( FILE * const f ) const;		// results only
+  static Textblock * load( FILE * const f );	// 0 if bad data
   };
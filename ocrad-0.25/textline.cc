@@ -59,7 +59,7 @@ int find_big_gap( const Textline & line, const int first,
 
 
 Textline::Textline( const Textline & tl )
-  : Track( tl ), big_initials_( tl.big_initials_ )
+  : Track( tl ), big_initials_( tl.big_initials_ ), table_( tl.table_ )
   {
   cpv.reserve( tl.cpv.size() );
   for( unsigned i = 0; i < tl.cpv.size(); ++i )
@@ -73,6 +73,7 @@ Textline & Textline::operator=( const Textline & tl )
     {
     Track::operator=( tl );
     big_initials_ = tl.big_initials_;
+    table_ = tl.table_;
     for( unsigned i = 0; i < cpv.size(); ++i ) delete cpv[i];
     cpv.clear();
     cpv.reserve( tl.cpv.size() );
@@ -122,6 +123,24 @@ Character * Textline::character_at( const int col ) const
   }
 
 
+// Returns the index of the first character whose hcenter is greater than
+// 'col'. Characters are kept sorted by hcenter, so a binary search is
+// used, followed by a local adjustment for characters left slightly out
+// of order by a join.
+int Textline::upper_index( const int col ) const
+  {
+  int l = 0, r = characters();
+  while( l < r )
+    {
+    const int m = ( l + r ) / 2;
+    if( cpv[m]->hcenter() <= col ) l = m + 1; else r = m;
+    }
+  while( l < characters() && cpv[l]->hcenter() <= col ) ++l;
+  while( l > 0 && cpv[l-1]->hcenter() > col ) --l;
+  return l;
+  }
+
+
 Rectangle Textline::charbox( const Character & c ) const
   {
   return Rectangle( c.left(), top( c.hcenter() ), c.right(), bottom( c.hcenter() ) );
@@ -143,17 +162,17 @@ void Textline::delete_character( const int i )
     Ocrad::internal_error( "delete_character, index out of bounds." );
   if( i < big_initials_ ) --big_initials_;
   delete cpv[i]; cpv.erase( cpv.begin() + i );
+  table_.clear();
   }
 
 
 int Textline::shift_characterp( Character * const p, const bool big )
   {
-  int i = characters();
-
-  while( i > 0 && p->h_precedes( *cpv[i-1] ) ) --i;
+  const int i = upper_index( p->hcenter() );
   cpv.insert( cpv.begin() + i, p );
   if( i < big_initials_ ) ++big_initials_;
   else if( big ) big_initials_ = i + 1;
+  table_.clear();
   return i;
   }
 
@@ -175,6 +194,7 @@ bool Textline::insert_space( const int i, const bool tab )
   Character * const p = new Character( re, ' ', tab ? 1 : 0 );
   if( tab ) p->add_guess( '\t', 0 );
   cpv.insert( cpv.begin() + i, p );
+  table_.clear();
   return true;
   }
 
@@ -229,7 +249,7 @@ void Textline::join( Textline & tl )
   {
   for( int i = 0; i < tl.characters(); ++i )
     shift_characterp( tl.cpv[i], i < tl.big_initials_ );
-  tl.big_initials_ = 0; tl.cpv.clear();
+  tl.big_initials_ = 0; tl.cpv.clear(); tl.table_.clear();
   }
 
 
@@ -293,7 +313,18 @@ int Textline::mean_vcenter() const
 
 void Textline::print( const Control & control ) const
   {
-  for( int i = 0; i < characters(); ++i ) character( i ).print( control );
+  const int * const code = column( c_code );
+  for( int i = 0; i < characters(); ++i )
+    {
+    if( code[i] < 0 ) std::putc( '_', control.outfile );
+    else if( !control.utf8 )
+      {
+      const unsigned char ch = UCS::map_to_byte( code[i] );
+      if( ch ) std::putc( ch, control.outfile );
+      }
+    else if( code[i] )
+      std::fputs( UCS::ucs_to_utf8( code[i] ), control.outfile );
+    }
   std::fputs( "\n", control.outfile );
   }
 
@@ -328,6 +359,78 @@ void Textline::xprint( const Control & control ) const
   }
 
 
+// Writes the boxes and guesses of the characters, which is all that is
+// needed to print the line or to query its results.
+void Textline::set_table() const
+  {
+  const int chars = characters();
+  table_.resize( columns * chars );
+  for( int i = 0; i < chars; ++i )
+    {
+    const Character & c = *cpv[i];
+    table_[c_left*chars+i] = c.left();
+    table_[c_top*chars+i] = c.top();
+    table_[c_right*chars+i] = c.right();
+    table_[c_bottom*chars+i] = c.bottom();
+    table_[c_code*chars+i] = c.guesses() ? c.guess( 0 ).code : -1;
+    table_[c_value*chars+i] = c.guesses() ? c.guess( 0 ).value : 0;
+    table_[c_guesses*chars+i] = c.guesses();
+    }
+  }
+
+
+const int * Textline::column( const Column col ) const
+  {
+  static const int empty = 0;
+  if( (int)table_.size() != columns * characters() ) set_table();
+  if( table_.empty() ) return &empty;
+  return &table_[col*characters()];
+  }
+
+
+void Textline::save( FILE * const f ) const
+  {
+  std::fprintf( f, "line %d %d\n", characters(), big_initials_ );
+  for( int i = 0; i < characters(); ++i )
+    {
+    const Character & c = character( i );
+    std::fprintf( f, "%d %d %d %d %d", c.left(), c.top(), c.right(),
+                  c.bottom(), c.guesses() );
+    for( int j = 0; j < c.guesses(); ++j )
+      std::fprintf( f, " %d %d", c.guess( j ).code, c.guess( j ).value );
+    std::fputc( '\n', f );
+    }
+  }
+
+
+bool Textline::load( FILE * const f )
+  {
+  int chars, big;
+  if( std::fscanf( f, " line %d %d", &chars, &big ) != 2 ||
+      chars < 0 || big < 0 || big > chars ) return false;
+  big_initials_ = big;
+  for( unsigned i = 0; i < cpv.size(); ++i ) delete cpv[i];
+  cpv.clear();
+  for( int i = 0; i < chars; ++i )
+    {
+    int l, t, r, b, guesses;
+    if( std::fscanf( f, "%d %d %d %d %d", &l, &t, &r, &b, &guesses ) != 5 ||
+        l > r || t > b || guesses < 0 ) return false;
+    Character * const p = new Character( Rectangle( l, t, r, b ), 0, 0 );
+    cpv.push_back( p );
+    p->clear_guesses();
+    for( int j = 0; j < guesses; ++j )
+      {
+      int code, value;
+      if( std::fscanf( f, "%d %d", &code, &value ) != 2 ) return false;
+      p->add_guess( code, value );
+      }
+    }
+  set_table();
+  return true;
+  }
+
+
 void Textline::cmark( Page_image & page_image ) const
   {
   for( int i = 0; i < characters(); ++i )
@@ -337,6 +440,7 @@ void Textline::cmark( Page_image & page_image ) const
 
 void Textline::recognize1( const Charset & charset ) const
   {
+  table_.clear();
   for( int i = 0; i < characters(); ++i )
     {
     Character & c = character( i );
@@ -355,9 +459,12 @@ void Textline::recognize1( const Charset & charset ) const
   }
 
 
-void Textline::apply_filter( const Filter::Type filter )
+// If 'thorough', unrecognized characters overlapping the previous one
+// are removed after the marking filters.
+void Textline::apply_filter( const Filter::Type filter, const bool thorough )
   {
   bool modified = false;
+  table_.clear();
   if( filter == Filter::same_height )
     {
     Histogram hist;
@@ -380,16 +487,18 @@ void Textline::apply_filter( const Filter::Type filter )
       if( !c.guesses() && filter != Filter::upper_num_mark )
         { delete_character( i ); modified = true; }
       }
-    if( filter == Filter::upper_num_mark )
+    if( filter == Filter::upper_num_mark && thorough )
       join_broken_unrecognized_characters();
     }
   if( modified ) remove_leadind_trailing_duplicate_spaces();
   }
 
 
-void Textline::apply_user_filter( const User_filter & user_filter )
+void Textline::apply_user_filter( const User_filter & user_filter,
+                                  const bool thorough )
   {
   bool modified = false;
+  table_.clear();
   for( int i = characters() - 1; i >= 0; --i )
     {
     Character & c = character( i );
@@ -398,7 +507,7 @@ void Textline::apply_user_filter( const User_filter & user_filter )
     if( !c.guesses() && user_filter.discard() )
       { delete_character( i ); modified = true; }
     }
-  if( user_filter.mark() ) join_broken_unrecognized_characters();
+  if( user_filter.mark() && thorough ) join_broken_unrecognized_characters();
   if( modified ) remove_leadind_trailing_duplicate_spaces();
   }
 
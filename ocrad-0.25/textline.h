@@ -22,10 +22,19 @@ class Textline : public Track
   {
   int big_initials_;
   mutable std::vector< Character * > cpv;
+  mutable std::vector< int > table_;	// results by columns, see set_table
 
   void check_lower_ambiguous();
+  void retry_unrecognized( const Charset & charset );
+  void join_split_characters();
 
 public:
+  // Columns of the table of results. Each column holds one value for
+  // each character, in the order of the characters. Characters without
+  // guesses have code -1 and value 0.
+  enum Column { c_left, c_top, c_right, c_bottom, c_code, c_value,
+                c_guesses, columns };
+
   Textline() : big_initials_( 0 ) {}
   Textline( const Textline & tl );
   Textline & operator=( const Textline & tl );
@@ -36,6 +45,7 @@ public:
   int big_initials() const { return big_initials_; }
   Character & character( const int i ) const;
   Character * character_at( const int col ) const;
+  int upper_index( const int col ) const;
   int characters() const { return cpv.size(); }
   Rectangle charbox( const Character & c ) const;
   int width() const
@@ -61,10 +71,22 @@ public:
   void xprint( const Control & control ) const;
   void cmark( Page_image & page_image ) const;
 
+  // Stores the boxes and first guesses of the final results in a
+  // compact table, read by 'column' without visiting the characters.
+  // Only the output and the queries on the results read the table;
+  // recognition, the filters, insert_spaces and the mean_* measures work
+  // on the characters, as they change them. Changing the characters
+  // discards the table, and 'column' builds it again on first use.
+  void set_table() const;
+  const int * column( const Column col ) const;
+
+  void save( FILE * const f ) const;		// results only
+  bool load( FILE * const f );			// false if bad data
+
   void recognize1( const Charset & charset ) const;
-  void recognize2( const Charset & charset );
-  void apply_filter( const Filter::Type filter );
-  void apply_user_filter( const User_filter & user_filter );
+  void recognize2( const Charset & charset, const bool thorough );
+  void apply_filter( const Filter::Type filter, const bool thorough );
+  void apply_user_filter( const User_filter & user_filter, const bool thorough );
   void join_broken_unrecognized_characters();
   void remove_leadind_trailing_duplicate_spaces();
   };
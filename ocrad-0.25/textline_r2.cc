@@ -100,10 +100,12 @@ void Textline::check_lower_ambiguous()
   }
 
 
-void Textline::recognize2( const Charset & charset )
+// Tries harder to recognize the characters left unrecognized by
+// recognize1, by splitting them into their blobs, removing speckles and
+// noise holes, or separating merged characters. This is the most
+// expensive part of the second pass.
+void Textline::retry_unrecognized( const Charset & charset )
   {
-  if( big_initials() >= characters() ) return;
-
   // try to recognize separately the 3 overlapped blobs of an
   // unrecognized character
   for( int i = big_initials(); i < characters(); ++i )
@@ -120,16 +122,16 @@ void Textline::recognize2( const Charset & charset )
         {
         if( b1.height() > b2.height() && b1.height() > b3.height() )
           {
-          Character c1( new Blob( b1 ) );
+          Character c1( c, 0 );
           c1.recognize1( charset, charbox( c1 ) );
           if( c1.guesses() ) c = c1;
           }
         else
           {
-          Character c2( new Blob( b2 ) );
-          Character c3( new Blob( b3 ) );
-          if( b2.h_includes( b1.hcenter() ) ) c2.shift_blobp( new Blob( b1 ) );
-          else if( b3.h_includes( b1.hcenter() ) ) c3.shift_blobp( new Blob( b1 ) );
+          Character c2( c, 1 );
+          Character c3( c, 2 );
+          if( b2.h_includes( b1.hcenter() ) ) c2.share_blob( c, 0 );
+          else if( b3.h_includes( b1.hcenter() ) ) c3.share_blob( c, 0 );
           c2.recognize1( charset, charbox( c2 ) );
           c3.recognize1( charset, charbox( c3 ) );
           if( c2.guesses() && c3.guesses() )
@@ -147,9 +149,9 @@ void Textline::recognize2( const Charset & charset )
     if( !c.guesses() && c.blobs() == 2 &&
         c.blob( 0 ).v_overlaps( c.blob( 1 ) ) )
       {
-      Character c1( new Blob( c.blob( 0 ) ) );
+      Character c1( c, 0 );
       c1.recognize1( charset, charbox( c1 ) );
-      Character c2( new Blob( c.blob( 1 ) ) );
+      Character c2( c, 1 );
       c2.recognize1( charset, charbox( c2 ) );
       if( ( c1.guesses() && c2.guesses() ) ||
           Ocrad::similar( c1.height(), c2.height(), 20 ) )
@@ -171,7 +173,7 @@ void Textline::recognize2( const Charset & charset )
         c.blob( 0 ).size() > 10 * c.blob( 1 ).size() &&
         c.blob( 1 ).top() > charbox( c ).bottom() )
       {
-      Character c1( new Blob( c.blob( 0 ) ) );
+      Character c1( c, 0 );
       c1.recognize1( charset, charbox( c1 ) );
       if( c1.guesses() ) c = c1;
       }
@@ -185,7 +187,7 @@ void Textline::recognize2( const Charset & charset )
         c.blob( 1 ).size() > 5 * c.blob( 0 ).size() &&
         c.blob( 0 ).bottom() + 2 * c.blob( 0 ).height() < charbox( c ).top() )
       {
-      Character c1( new Blob( c.blob( 1 ) ) );
+      Character c1( c, 1 );
       c1.recognize1( charset, charbox( c1 ) );
       if( c1.guesses() ) c = c1;
       }
@@ -234,8 +236,8 @@ void Textline::recognize2( const Charset & charset )
       for( int j = 0; j < c.blobs(); ++j ) if( j != ib )
         {
         const Blob & bj = c.blob( j );
-        if( c1.includes_hcenter( bj ) ) c1.shift_blobp( new Blob( bj ) );
-        else if( c2.includes_hcenter( bj ) ) c2.shift_blobp( new Blob( bj ) );
+        if( c1.includes_hcenter( bj ) ) c1.share_blob( c, j );
+        else if( c2.includes_hcenter( bj ) ) c2.share_blob( c, j );
         }
       c1.recognize1( charset, charbox( c1 ) );
       c2.recognize1( charset, charbox( c2 ) );
@@ -257,7 +259,7 @@ void Textline::recognize2( const Charset & charset )
     if( !c.guesses() && c.blobs() == 1 && c.blob( 0 ).holes() )
       {
       Character c1( c );
-      Blob & b = c1.blob( 0 );
+      Blob & b = c1.unshared_blob( 0 );
       for( int j = b.holes() - 1; j >= 0; --j )
         if( 64 * b.hole( j ).size() <= b.size() ||
             16 * b.hole( j ).height() <= b.height() ) b.fill_hole( j );
@@ -275,6 +277,20 @@ void Textline::recognize2( const Charset & charset )
         }*/
       }
     }
+  }
+
+
+// If not 'thorough', the retries on unrecognized characters and the
+// joining and splitting of characters are skipped. The merged
+// characters found by recognize1 are always separated, as their guesses
+// are not valid codes until then, and the choices between similar
+// characters by context are always made.
+void Textline::recognize2( const Charset & charset, const bool thorough )
+  {
+  table_.clear();
+  if( big_initials() >= characters() ) return;
+
+  if( thorough ) retry_unrecognized( charset );
 
   // separate merged characters recognized by recognize1
   for( int i = big_initials(); i < characters(); )
@@ -297,7 +313,7 @@ void Textline::recognize2( const Charset & charset )
         for( int k = 0; k < c.blobs(); ++k )
           if( k != blob_index && !c.blob( k ).includes( re ) &&
               re.includes_hcenter( c.blob( k ) ) )
-            c1.shift_blobp( new Blob( c.blob( k ) ) );
+            c1.share_blob( c, k );
         c1.add_guess( c.guess( g ).code, 0 );
         shift_characterp( new Character( c1 ) );
         left = re.right() + 1;
@@ -713,6 +729,27 @@ void Textline::recognize2( const Charset & charset )
       }
     }
 
+  // choose between '.' and '-'
+  if( characters() >= 2 )
+    {
+    Character & c = character( characters() - 1 );
+    if( c.guesses() >= 2 &&
+        c.guess( 0 ).code == '.' && c.guess( 1 ).code == '-' )
+      {
+      const Character & lc = character( characters() - 2 );
+      if( lc.guesses() && UCS::isalpha( lc.guess( 0 ).code ) )
+        c.swap_guesses( 0, 1 );
+      }
+    }
+
+  if( thorough ) join_split_characters();
+  }
+
+
+// Joins the pieces of characters split in the first pass, like two
+// single quotes or a comma and a period, and splits merged 'VV'.
+void Textline::join_split_characters()
+  {
   // join two adjacent single quotes into a double quote
   for( int i = big_initials(); i < characters() - 1; ++i )
     {
@@ -743,19 +780,6 @@ void Textline::recognize2( const Charset & charset )
       }
     }
 
-  // choose between '.' and '-'
-  if( characters() >= 2 )
-    {
-    Character & c = character( characters() - 1 );
-    if( c.guesses() >= 2 &&
-        c.guess( 0 ).code == '.' && c.guess( 1 ).code == '-' )
-      {
-      const Character & lc = character( characters() - 2 );
-      if( lc.guesses() && UCS::isalpha( lc.guess( 0 ).code ) )
-        c.swap_guesses( 0, 1 );
-      }
-    }
-
   // join a 'n' followed by a 'I' into a 'm'
   for( int i = big_initials(); i < characters() - 1; ++i )
     {
@@ -830,5 +854,4 @@ void Textline::recognize2( const Charset & charset )
         }
       }
     }
-
   }
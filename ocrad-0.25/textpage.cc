@@ -18,6 +18,7 @@
 #include <algorithm>
 #include <cstdio>
 #include <cstdlib>
+#include <new>
 #include <string>
 #include <vector>
 #include <stdint.h>
@@ -29,12 +30,16 @@
 #include "track.h"
 #include "ucs.h"
 #include "bitmap.h"
+#include "bitplane.h"
 #include "blob.h"
 #include "character.h"
+#include "frame_cache.h"
 #include "page_image.h"
+#include "parallel.h"
 #include "textline.h"
 #include "textblock.h"
 #include "textpage.h"
+#include "trace.h"
 
 
 namespace {
@@ -183,17 +188,52 @@ void remove_left_right_noise( std::vector< Blob * > & blobp_vector )
   }
 
 
-void find_holes( std::vector< Zone > & zone_vector )
+// Blobs larger than 'max_size' pixels (if > 0) are left without holes.
+void find_holes( std::vector< Zone > & zone_vector, const long long max_size )
   {
   for( unsigned zi = 0; zi < zone_vector.size(); ++zi )
     {
     std::vector< Blob * > & blobp_vector = zone_vector[zi].blobp_vector;
     for( unsigned bvi = 0; bvi < blobp_vector.size(); ++bvi )
-      blobp_vector[bvi]->find_holes();
+      if( max_size <= 0 || blobp_vector[bvi]->size() <= max_size )
+        blobp_vector[bvi]->find_holes();
     }
   }
 
 
+const int heap_overhead = 16;		// bytes added to each allocation
+
+// Estimated number of bytes used by a bitmap stored as a vector of rows.
+long long bitmap_bytes( const Rectangle & re )
+  {
+  return (long long)re.height() *
+         ( re.width() + sizeof( std::vector< uint8_t > ) + heap_overhead ) +
+         heap_overhead;
+  }
+
+
+long long blob_bytes( const std::vector< Blob * > & blobp_vector )
+  {
+  long long sum = 0;
+  for( unsigned i = 0; i < blobp_vector.size(); ++i )
+    sum += bitmap_bytes( *blobp_vector[i] ) + sizeof (Blob) + heap_overhead;
+  return sum;
+  }
+
+
+// Estimated number of bytes used by the blobs labeled from 'bitplane',
+// computed without labeling. Each run may start a blob and adds at most
+// a row to one, and the boxes of glyphs are about 4 times their ink.
+long long label_bytes( const Bitplane & bitplane )
+  {
+  long runs, top_runs;
+  bitplane.count_runs( runs, top_runs );
+  return top_runs * ( sizeof (Blob) + 2LL * heap_overhead ) +
+         runs * ( sizeof( std::vector< uint8_t > ) + (long long)heap_overhead ) +
+         4LL * bitplane.ink();
+  }
+
+
 void ignore_wide_blobs( const Rectangle & re,
                         std::vector< Blob * > & blobp_vector )
   {
@@ -244,7 +284,9 @@ void ignore_wide_blobs( const Rectangle & re,
   }
 
 
-int mean_blob_height( const std::vector< Blob * > & blobp_vector )
+// Blobs lower than 'min_height' are ignored as noise unless all are.
+int mean_blob_height( const std::vector< Blob * > & blobp_vector,
+                      const int min_height = 10 )
   {
   int mean_height = 0;
   unsigned samples = 0;
@@ -254,7 +296,7 @@ int mean_blob_height( const std::vector< Blob * > & blobp_vector )
     {
     const unsigned h = blobp_vector[i]->height();
     const unsigned w = blobp_vector[i]->width();
-    if( h < 10 || w >= 3 * h ) continue;
+    if( (int)h < min_height || w >= 3 * h ) continue;
     if( h >= height_distrib.size() ) height_distrib.resize( h + 1 );
     ++height_distrib[h]; ++samples;
     }
@@ -361,30 +403,140 @@ int analyse_layout( std::vector< Blob * > & blobp_vector,
   }
 
 
-void scan_page( const Page_image & page_image, std::vector< Zone > & zone_vector,
-                const int debug_level, const bool layout )
+// Coarse layout pass. Counts the black pixels of 'bitplane' in square
+// cells of side 4 (or 8 for large pages), labels the regions of cells
+// with ink, classifies them as text, picture or rule, and erases the
+// pictures and rules from 'bitplane' so that only text regions are
+// labeled at full resolution.
+// A cell is "ink" if it is at least one quarter black, and "dense" if it
+// is at least half black. Pictures are regions mostly made of dense
+// cells and at least 3 times taller than the median region, which is
+// usually a character or word; large glyphs alone are not pictures.
+// Rules are long regions one or two cells thick without gaps. Anything
+// else is left for the full resolution filters.
+void coarse_layout( Bitplane & bitplane, int & pictures, int & rules )
   {
-  const Rectangle & re = page_image;
-  const int zthreshold = page_image.threshold();
-  std::vector< Blob * > blobp_vector;
-  std::vector< Blob * > old_data( re.width(), (Blob *) 0 );
-  std::vector< Blob * > new_data( re.width(), (Blob *) 0 );
+  struct Region
+    {
+    Rectangle re;
+    int ink, dense;
+    explicit Region( const Rectangle & r ) : re( r ), ink( 0 ), dense( 0 ) {}
+    };
+
+  pictures = rules = 0;
+  const int scale =
+    ( std::min( bitplane.width(), bitplane.height() ) >= 3200 ) ? 8 : 4;
+  const int scale2 = scale * scale;
+  const int width = bitplane.width() / scale, height = bitplane.height() / scale;
+  std::vector< uint8_t > cover( width * height, 0 );	// black pixels
+  for( int row = 0; row < height * scale; ++row )
+    {
+    uint8_t * const crow = &cover[( row / scale ) * width];
+    const int brow = bitplane.top() + row;
+    if( bitplane.blank_row( brow ) ) continue;
+    for( int col = 0; col < width; ++col )
+      {
+      const int bcol = bitplane.left() + col * scale;
+      crow[col] += bitplane.black_pixels( brow, bcol, bcol + scale - 1 );
+      }
+    }
 
-  for( int row = re.top(); row <= re.bottom(); ++row )
+  std::vector< uint8_t > seen( width * height, 0 );
+  std::vector< int > stack;
+  std::vector< Region > regions;
+  std::vector< int > heights;
+  for( int row = 0; row < height; ++row )
+    for( int col = 0; col < width; ++col )
+      {
+      if( seen[row*width+col] || 4 * cover[row*width+col] < scale2 )
+        continue;
+      seen[row*width+col] = 1;
+      stack.push_back( row * width + col );
+      regions.push_back( Region( Rectangle( col, row, col, row ) ) );
+      Region & region = regions.back();
+      while( !stack.empty() )
+        {
+        const int r = stack.back() / width, c = stack.back() % width;
+        stack.pop_back();
+        ++region.ink; if( 2 * cover[r*width+c] >= scale2 ) ++region.dense;
+        region.re.add_point( r, c );
+        for( int nr = std::max( 0, r - 1 ); nr <= std::min( height - 1, r + 1 ); ++nr )
+          for( int nc = std::max( 0, c - 1 ); nc <= std::min( width - 1, c + 1 ); ++nc )
+            if( !seen[nr*width+nc] && 4 * cover[nr*width+nc] >= scale2 )
+              { seen[nr*width+nc] = 1; stack.push_back( nr * width + nc ); }
+        }
+      if( region.re.height() >= 2 ) heights.push_back( region.re.height() );
+      }
+  if( regions.empty() ) return;
+  int min_picture_height = 16;
+  if( heights.size() )
+    {
+    std::nth_element( heights.begin(), heights.begin() + heights.size() / 2,
+                      heights.end() );
+    min_picture_height =
+      std::max( min_picture_height, 3 * heights[heights.size()/2] );
+    }
+
+  for( unsigned i = 0; i < regions.size(); ++i )
+    {
+    const Rectangle & re = regions[i].re;
+    const int ink = regions[i].ink, dense = regions[i].dense;
+    const bool picture = ( re.width() >= 16 && re.height() >= min_picture_height &&
+                           2 * dense >= re.size() );
+    const bool hrule = ( re.height() <= 2 && re.width() >= 32 &&
+                         20 * ink >= 19 * re.size() );
+    const bool vrule = ( re.width() <= 2 && re.height() >= 32 &&
+                         20 * ink >= 19 * re.size() );
+    if( !picture && !hrule && !vrule ) continue;
+    // erase the region plus one cell around it, catching the light
+    // edges of the region. Rules are only extended lengthwise.
+    const int lpad = ( picture || hrule ) ? scale : 0;
+    const int tpad = ( picture || vrule ) ? scale : 0;
+    bitplane.clear_rectangle(
+      Rectangle( bitplane.left() + re.left() * scale - lpad,
+                 bitplane.top() + re.top() * scale - tpad,
+                 bitplane.left() + ( re.right() + 1 ) * scale - 1 + lpad,
+                 bitplane.top() + ( re.bottom() + 1 ) * scale - 1 + tpad ) );
+    if( picture ) ++pictures; else ++rules;
+    }
+  }
+
+
+// Labels the 8-connected black components of rows [top, bottom] of
+// 'bitplane', which must have no black pixels outside the columns of
+// 'box', with a raster scan. The blobs are appended to 'blobp_vector' in
+// the order of their first pixel. White spans (including blank rows) are
+// skipped a word at a time.
+void label_rows( const Bitplane & bitplane, const Rectangle & box,
+                 const int top, const int bottom,
+                 std::vector< Blob * > & blobp_vector )
+  {
+  std::vector< Blob * > old_data( box.width(), (Blob *) 0 );
+  std::vector< Blob * > new_data( box.width(), (Blob *) 0 );
+  bool old_blank = true, new_blank = true;	// data known to be all 0
+
+  for( int row = top; row <= bottom; ++row )
     {
-    old_data.swap( new_data );
-    for( int col = re.left(); col <= re.right(); ++col )
+    old_data.swap( new_data ); std::swap( old_blank, new_blank );
+    if( !new_blank )
       {
-      const int dcol = col - re.left();
-      if( !page_image.get_bit( row, col, zthreshold ) )
-        new_data[dcol] = 0;			// white pixel
-      else					// black pixel
+      std::fill( new_data.begin(), new_data.end(), (Blob *) 0 );
+      new_blank = true;
+      }
+    int col = bitplane.next_black( row, box.left() );
+    while( col <= box.right() )			// for each black run
+      {
+      new_blank = false;
+      const int end = std::min( box.right(),
+                                bitplane.next_white( row, col ) - 1 );
+      for( ; col <= end; ++col )
         {
+        const int dcol = col - box.left();
         Blob *p;
         Blob *lp  = ( (dcol > 0) ? new_data[dcol-1] : 0 );
         Blob *ltp = ( (dcol > 0) ? old_data[dcol-1] : 0 );
         Blob *tp  = old_data[dcol];
-        Blob *rtp = ( (col < re.right()) ? old_data[dcol+1] : 0 );
+        Blob *rtp = ( (col < box.right()) ? old_data[dcol+1] : 0 );
         if( lp )       { p = lp;  p->add_point( row, col ); }
         else if( ltp ) { p = ltp; p->add_point( row, col ); }
         else if( tp )  { p = tp;  p->add_point( row, col ); }
@@ -399,11 +551,213 @@ void scan_page( const Page_image & page_image, std::vector< Zone > & zone_vector
         if( rtp && p != rtp )
           join_blobs( blobp_vector, old_data, new_data, p, rtp, dcol );
         }
+      col = bitplane.next_black( row, col );
       }
     }
+  }
+
+
+struct Strips
+  {
+  const Bitplane & bitplane;
+  const Rectangle & box;
+  std::vector< int > tops;			// first row of each strip
+  std::vector< std::vector< Blob * > > blobp_vectors;
+  std::vector< char > failed;			// strip ran out of memory
+
+  Strips( const Bitplane & bp, const Rectangle & re, const int strips );
+  int bottom( const int i ) const { return tops[i+1] - 1; }
+  };
+
+
+Strips::Strips( const Bitplane & bp, const Rectangle & re, const int strips )
+  : bitplane( bp ), box( re ), blobp_vectors( strips ), failed( strips, 0 )
+  {
+  for( int i = 0; i < strips; ++i )
+    tops.push_back( re.top() + (int)( (long long)re.height() * i / strips ) );
+  tops.push_back( re.bottom() + 1 );
+  }
+
+
+void strip_job( void * const arg, const int i )
+  {
+  Strips & strips = *(Strips *)arg;
+  const Trace::Span span( "label strip", i );
+  try
+    {
+    label_rows( strips.bitplane, strips.box, strips.tops[i],
+                strips.bottom( i ), strips.blobp_vectors[i] );
+    }
+  catch( std::bad_alloc ) { strips.failed[i] = 1; }
+  }
+
+
+int find_root( std::vector< int > & parent, int i )
+  {
+  while( parent[i] != i ) { parent[i] = parent[parent[i]]; i = parent[i]; }
+  return i;
+  }
+
+
+// Sets label[col] to the index of the blob (counting from 'first')
+// having a black pixel at (row, col).
+void paint_row( const std::vector< Blob * > & blobp_vector, const int first,
+                const int row, const int left, std::vector< int > & label )
+  {
+  for( unsigned i = 0; i < blobp_vector.size(); ++i )
+    {
+    const Blob & b = *blobp_vector[i];
+    if( b.top() <= row && b.bottom() >= row )
+      for( int col = b.left(); col <= b.right(); ++col )
+        if( b.get_bit( row, col ) ) label[col-left] = first + i;
+    }
+  }
+
+
+// Labels each horizontal strip of 'box' in parallel, then joins the
+// blobs touching across the borders between strips using a union-find.
+// The resulting blobs are the same produced by 'label_rows' over the
+// whole box.
+void label_strips( const Bitplane & bitplane, const Rectangle & box,
+                   const int threads, std::vector< Blob * > & blobp_vector )
+  {
+  const int min_strip_height = 32;
+  const int strips = std::min( 4 * threads, box.height() / min_strip_height );
+  if( threads <= 1 || strips <= 1 )
+    {
+    label_rows( bitplane, box, box.top(), box.bottom(), blobp_vector );
+    return;
+    }
+
+  Strips st( bitplane, box, strips );
+  Ocrad::parallel_run( strip_job, &st, strips, threads );
+  // rethrow in the calling thread after releasing the partial strips
+  if( std::find( st.failed.begin(), st.failed.end(), 1 ) != st.failed.end() )
+    {
+    for( int i = 0; i < strips; ++i )
+      for( unsigned j = 0; j < st.blobp_vectors[i].size(); ++j )
+        delete st.blobp_vectors[i][j];
+    throw std::bad_alloc();
+    }
+
+  std::vector< int > first( strips + 1, 0 );	// index of first blob
+  for( int i = 0; i < strips; ++i )
+    first[i+1] = first[i] + st.blobp_vectors[i].size();
+  std::vector< int > parent( first[strips] );
+  for( unsigned i = 0; i < parent.size(); ++i ) parent[i] = i;
+
+  const int left = box.left(), width = box.width();
+  std::vector< int > upper( width ), lower( width );
+  for( int i = 0; i + 1 < strips; ++i )
+    {
+    const int row = st.bottom( i );
+    std::fill( upper.begin(), upper.end(), -1 );
+    std::fill( lower.begin(), lower.end(), -1 );
+    paint_row( st.blobp_vectors[i], first[i], row, left, upper );
+    paint_row( st.blobp_vectors[i+1], first[i+1], row + 1, left, lower );
+    for( int col = 0; col < width; ++col )
+      {
+      if( lower[col] < 0 ) continue;
+      for( int c = std::max( 0, col - 1 ); c <= col + 1 && c < width; ++c )
+        if( upper[c] >= 0 )
+          {
+          const int r1 = find_root( parent, upper[c] );
+          const int r2 = find_root( parent, lower[col] );
+          if( r1 < r2 ) parent[r2] = r1; else parent[r1] = r2;
+          }
+      }
+    }
+
+  // the blob created first in each set absorbs the rest
+  std::vector< Blob * > all;
+  all.reserve( parent.size() );
+  for( int i = 0; i < strips; ++i )
+    all.insert( all.end(), st.blobp_vectors[i].begin(),
+                st.blobp_vectors[i].end() );
+  for( unsigned i = 0; i < all.size(); ++i )
+    {
+    const int r = find_root( parent, i );
+    if( r != (int)i ) { all[r]->add_bitmap( *all[i] ); delete all[i]; }
+    else blobp_vector.push_back( all[i] );
+    }
+  }
+
+
+// Memory needed to recognize 'page_image' once binarized as 'bitplane';
+// the image, the bitplane and the blobs.
+long long page_bytes( const Rectangle & re, const Bitplane & bitplane )
+  { return bitmap_bytes( re ) + bitplane.bytes() + label_bytes( bitplane ); }
+
+
+// If the blobs estimated from the bitplane don't fit in the memory
+// budget of 'control', std::bad_alloc is thrown before labeling them.
+// Holes are not searched in the blobs too large for the memory left.
+// 'memory_peak' is set to the estimated memory used. If 'cache' is not
+// null, the bitplane is compared with the one of the last frame.
+void scan_page( const Page_image & page_image, const uint8_t threshold,
+                std::vector< Zone > & zone_vector, const Control & control,
+                const bool layout, long long & memory_peak,
+                Frame_cache * const cache, const int threads )
+  {
+  const Rectangle & re = page_image;
+  const int debug_level = control.debug_level;
+  const long long budget = control.memory_budget();
+  const long long image_bytes = bitmap_bytes( re );
+  const Trace::Span span( "scan_page" );
+  std::vector< Blob * > blobp_vector;
+  {
+  Trace::Span binarize( "binarize" );
+  Bitplane bitplane( page_image, threshold, control.window, threads );
+  binarize.end();
+  memory_peak = image_bytes + bitplane.bytes();
+  if( control.despeckle > 0 )		// remove noise before labeling
+    {
+    const Trace::Span span( "despeckle" );
+    const int removed = bitplane.remove_speckles( control.despeckle );
+    if( verbosity >= 1 )
+      std::fprintf( stderr, "despeckle removed %d pixels\n", removed );
+    }
+  if( control.coarse_layout && re.width() > 200 && re.height() > 200 )
+    {
+    const Trace::Span span( "coarse_layout" );
+    int pictures, rules;
+    coarse_layout( bitplane, pictures, rules );
+    if( verbosity >= 1 )
+      std::fprintf( stderr, "coarse layout removed %d pictures and %d rules\n",
+                    pictures, rules );
+    }
+  if( cache )
+    {
+    const Trace::Span span( "diff_frame" );
+    cache->new_frame( bitplane, control );
+    if( verbosity >= 1 )
+      std::fprintf( stderr, "%d of %d tiles changed since last frame\n",
+                    cache->dirty_tiles(), cache->tiles() );
+    }
+  if( budget > 0 )
+    {
+    const Trace::Span span( "memory estimate" );
+    const long long estimate = page_bytes( re, bitplane );
+    if( verbosity >= 1 )
+      std::fprintf( stderr, "memory limit: %lld KiB estimated before labeling\n",
+                    estimate / 1024 );
+    if( estimate > budget ) throw std::bad_alloc();
+    }
+  Rectangle box( re );
+  if( bitplane.content_box( box ) )		// skip white margins
+    {
+    if( verbosity >= 1 )
+      std::fprintf( stderr, "content box %dw x %dh at %d,%d\n",
+                    box.width(), box.height(), box.left(), box.top() );
+    const Trace::Span span( "label" );
+    label_strips( bitplane, box, threads, blobp_vector );
+    }
+  memory_peak += blob_bytes( blobp_vector );
+  }
 
   if( debug_level <= 99 && blobp_vector.size() > 3 )
     {
+    const Trace::Span span( "remove noise" );
     ignore_wide_blobs( re, blobp_vector );
     ignore_small_blobs( blobp_vector );
     ignore_abnormal_blobs( blobp_vector );
@@ -414,7 +768,9 @@ void scan_page( const Page_image & page_image, std::vector< Zone > & zone_vector
   if( layout && re.width() > 200 && re.height() > 200 &&
       blobp_vector.size() > 3 )
     {
+    Trace::Span span( "analyse_layout" );
     analyse_layout( blobp_vector, zone_vector );
+    span.end();
     if( debug_level <= 99 && zone_vector.size() > 1 )
       for( unsigned i = 0; i < zone_vector.size(); ++i )
         ignore_wide_blobs( zone_vector[i].mask, zone_vector[i].blobp_vector );
@@ -424,21 +780,91 @@ void scan_page( const Page_image & page_image, std::vector< Zone > & zone_vector
     zone_vector.push_back( Zone( re ) );
     zone_vector.back().blobp_vector.swap( blobp_vector );
     }
-  find_holes( zone_vector );
+  const Trace::Span holes( "find_holes" );
+  long long max_size = 0;
+  if( budget > 0 )		// hole labeling uses about 8 bytes per pixel
+    {
+    long long used = image_bytes;
+    for( unsigned i = 0; i < zone_vector.size(); ++i )
+      used += blob_bytes( zone_vector[i].blobp_vector );
+    max_size = std::max( 1LL, ( budget - used ) / 8 );
+    }
+  find_holes( zone_vector, max_size );
+  }
+
+
+// Returns the mean height of the blobs of 'page_image', or 0 if they
+// are too few or too large to be text.
+int text_height( const Page_image & page_image, const int min_height,
+                 const int threads )
+  {
+  const Bitplane bitplane( page_image );
+  Rectangle box( page_image );
+  if( !bitplane.content_box( box ) ) return 0;
+  std::vector< Blob * > blobp_vector;
+  label_strips( bitplane, box, threads, blobp_vector );
+  int height = 0;
+  if( blobp_vector.size() >= 8 )
+    height = mean_blob_height( blobp_vector, min_height );
+  if( 4 * height > std::min( page_image.width(), page_image.height() ) )
+    height = 0;
+  for( unsigned i = 0; i < blobp_vector.size(); ++i ) delete blobp_vector[i];
+  return height;
+  }
+
+
+struct Sweep
+  {
+  const Page_image & page_image;
+  const char * const filename;
+  const Control & control;
+  const bool layout;
+  const std::vector< int > & thresholds;
+  std::vector< Textpage * > & textpages;
+  const int threads;			// threads of each job
+
+  Sweep( const Page_image & pi, const char * const name, const Control & c,
+         const bool l, const std::vector< int > & th,
+         std::vector< Textpage * > & tp, const int t )
+    : page_image( pi ), filename( name ), control( c ), layout( l ),
+      thresholds( th ), textpages( tp ), threads( t ) {}
+  };
+
+
+void sweep_job( void * const arg, const int i )
+  {
+  const Sweep & sw = *(const Sweep *)arg;
+  try
+    {
+    sw.textpages[i] = new Textpage( sw.page_image, sw.filename, sw.control,
+                                    sw.layout, sw.thresholds[i], 0,
+                                    sw.threads );
+    }
+  catch( ... ) { sw.textpages[i] = 0; }
   }
 
 } // end namespace
 
 
 Textpage::Textpage( const Page_image & page_image, const char * const filename,
-                    const Control & control, const bool layout )
-  : Rectangle( page_image ), name( filename )
+                    const Control & control, const bool layout,
+                    const int threshold, Frame_cache * const cache,
+                    const int threads )
+  : Rectangle( page_image ), name( filename ), memory_peak_( 0 ),
+    unfiltered_kept( control.keep_unfiltered && control.debug_level == 0 )
   {
   const int debug_level = control.debug_level;
   if( debug_level < 0 || debug_level > 100 ) return;
+  const Trace::Span span( "Textpage" );
 
   std::vector< Zone > zone_vector;			// layout zones
-  scan_page( page_image, zone_vector, debug_level, layout );
+  scan_page( page_image,
+             ( threshold >= 0 ) ? threshold : page_image.threshold(),
+             zone_vector, control, layout, memory_peak_, cache,
+             ( threads > 0 ) ? threads : control.threads );
+  if( verbosity >= 1 )
+    std::fprintf( stderr, "estimated memory peak = %lld KiB\n",
+                  memory_peak_ / 1024 );
   if( verbosity >= 1 )
     std::fprintf( stderr, "number of text blocks = %d\n", (int)zone_vector.size() );
 
@@ -452,13 +878,23 @@ Textpage::Textpage( const Page_image & page_image, const char * const filename,
   // build a Textblock for every zone with text
   for( unsigned i = 0; i < zone_vector.size(); ++i )
     {
+    Trace::Span build( "Textblock", i );
     Textblock * const tbp = new Textblock( page_image, zone_vector[i].mask,
                                            zone_vector[i].blobp_vector );
+    build.end();
     if( tbp->textlines() && debug_level < 90 )
-      tbp->recognize( control );
+      {
+      const Trace::Span span( "recognize", i );
+      tbp->recognize( control, cache );
+      if( unfiltered_kept ) unfiltered.push_back( new Textblock( *tbp ) );
+      tbp->apply_filters( control );
+      }
     if( tbp->textlines() ) tbpv.push_back( tbp );
     else delete tbp;
     }
+  if( cache && verbosity >= 1 )
+    std::fprintf( stderr, "%d of %d lines reused from last frame\n",
+                  cache->reused_lines(), cache->lines() );
   if( debug_level == 0 ) return;
   if( !control.outfile ) return;
   if( debug_level >= 86 )
@@ -493,9 +929,107 @@ Textpage::Textpage( const Page_image & page_image, const char * const filename,
   }
 
 
+// The text height is estimated on a copy of the image reduced so that
+// its smaller side is about 400 pixels (by at most 8), which is enough
+// to tell apart the text heights that need scaling and costs a fraction
+// of the full labeling.
+// Heights of 60 pixels or more are reduced to between 30 and 60; heights
+// between 5 and 19 are enlarged to at least 20, up to 4 times.
+int Textpage::auto_scale( const Page_image & page_image, const Control & control )
+  {
+  enum { min_text_height = 20, max_text_height = 60, max_enlarge = 4 };
+  const Trace::Span span( "auto_scale" );
+  const int r =
+    std::min( 8, std::min( page_image.width(), page_image.height() ) / 400 );
+  const int height = ( r >= 2 ) ?
+    r * text_height( Page_image( page_image, r ), std::max( 2, 10 / r ),
+                     control.threads ) :
+    text_height( page_image, 10, control.threads );
+
+  int scale = 0;
+  if( height >= max_text_height )
+    scale = -( height / ( max_text_height / 2 ) );
+  else if( height >= 5 && height < min_text_height )
+    scale = std::min( (int)max_enlarge,
+                      ( min_text_height + height - 1 ) / height );
+  if( verbosity >= 1 )
+    std::fprintf( stderr, "auto scale: text height %d, scale %d\n",
+                  height, scale );
+  return scale;
+  }
+
+
+// Runs up to 'control.threads' recognitions at once, dividing the
+// threads among them. Each recognition uses its own bitplane and blobs;
+// the image is shared.
+void Textpage::sweep( const Page_image & page_image, const char * const filename,
+                      const Control & control, const bool layout,
+                      const std::vector< int > & thresholds,
+                      std::vector< Textpage * > & textpages )
+  {
+  const int jobs = thresholds.size();
+  textpages.assign( jobs, (Textpage *)0 );
+  const Sweep sw( page_image, filename, control, layout, thresholds, textpages,
+                 std::max( 1, control.threads / std::max( 1, jobs ) ) );
+  Ocrad::parallel_run( sweep_job, (void *)&sw, jobs, control.threads );
+  }
+
+
+bool Textpage::fit_memory( Page_image & page_image, const Control & control )
+  {
+  const long long budget = control.memory_budget();
+  if( budget <= 0 ) return true;
+  while( true )
+    {
+    // binarize only once the image and its bitplane fit
+    const long long fixed = bitmap_bytes( page_image ) +
+      (long long)page_image.height() * ( ( page_image.width() + 63 ) / 64 ) * 8;
+    if( fixed < budget )
+      {
+      const Bitplane bitplane( page_image, -1, control.window, control.threads );
+      if( page_bytes( page_image, bitplane ) <= budget ) return true;
+      }
+    if( std::min( page_image.width(), page_image.height() ) < 6 ) return false;
+    page_image.change_scale( -2 );
+    if( verbosity >= 1 )
+      std::fprintf( stderr, "memory limit: image reduced to %dw x %dh\n",
+                    page_image.width(), page_image.height() );
+    }
+  }
+
+
 Textpage::~Textpage()
   {
   for( int i = textblocks() - 1; i >= 0; --i ) delete tbpv[i];
+  for( unsigned i = unfiltered.size(); i > 0; --i ) delete unfiltered[i-1];
+  }
+
+
+// Filtering a copy costs a small fraction of recognizing the page,
+// because the characters keep their guesses and are not recognized again.
+bool Textpage::apply_filters( const Control & control )
+  {
+  if( !unfiltered_kept ) return false;
+  const Trace::Span span( "refilter" );
+  std::vector< Textblock * > new_tbpv;
+  try
+    {
+    for( unsigned i = 0; i < unfiltered.size(); ++i )
+      {
+      new_tbpv.push_back( new Textblock( *unfiltered[i] ) );
+      new_tbpv.back()->apply_filters( control );
+      if( !new_tbpv.back()->textlines() )
+        { delete new_tbpv.back(); new_tbpv.pop_back(); }
+      }
+    }
+  catch( ... )
+    {
+    for( unsigned i = 0; i < new_tbpv.size(); ++i ) delete new_tbpv[i];
+    throw;
+    }
+  for( int i = textblocks() - 1; i >= 0; --i ) delete tbpv[i];
+  tbpv.swap( new_tbpv );
+  return true;
   }
 
 
@@ -525,6 +1059,33 @@ int Textpage::characters() const
   }
 
 
+// Single guesses count 2, ambiguous characters 1, and unrecognized
+// characters -4, as a broken character usually produces several
+// unrecognized pieces. Spaces are not counted.
+int Textpage::score() const
+  {
+  int score = 0;
+  for( int b = 0; b < textblocks(); ++b )
+    {
+    const Textblock & block = *tbpv[b];
+    for( int l = 0; l < block.textlines(); ++l )
+      {
+      const Textline & line = block.textline( l );
+      const int * const code = line.column( Textline::c_code );
+      const int * const guesses = line.column( Textline::c_guesses );
+      for( int i = 0; i < line.characters(); ++i )
+        {
+        if( guesses[i] == 0 ) score -= 4;
+        else if( code[i] == ' ' ) continue;
+        else if( guesses[i] == 1 ) score += 2;
+        else ++score;
+        }
+      }
+    }
+  return score;
+  }
+
+
 void Textpage::print( const Control & control ) const
   {
   if( control.outfile )
@@ -533,6 +1094,33 @@ void Textpage::print( const Control & control ) const
   }
 
 
+void Textpage::save( FILE * const f ) const
+  {
+  std::fprintf( f, "page %d %d %d %d %lld %d\n", left(), top(), right(),
+                bottom(), memory_peak_, textblocks() );
+  for( int i = 0; i < textblocks(); ++i ) tbpv[i]->save( f );
+  }
+
+
+Textpage * Textpage::load( FILE * const f, const char * const filename )
+  {
+  int l, t, r, b, blocks;
+  long long peak;
+  if( std::fscanf( f, " page %d %d %d %d %lld %d", &l, &t, &r, &b, &peak,
+                   &blocks ) != 6 || l > r || t > b || blocks < 0 )
+    return 0;
+  Textpage * const tp = new Textpage( Rectangle( l, t, r, b ), filename );
+  tp->memory_peak_ = peak;
+  for( int i = 0; i < blocks; ++i )
+    {
+    Textblock * const tbp = Textblock::load( f );
+    if( !tbp ) { delete tp; return 0; }
+    tp->tbpv.push_back( tbp );
+    }
+  return tp;
+  }
+
+
 void Textpage::xprint( const Control & control ) const
   {
   if( !control.exportfile ) return;
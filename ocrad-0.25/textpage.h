@@ -15,26 +15,69 @@
     along with this program.  If not, see <http://www.gnu.org/licenses/>.
 */
 
+class Frame_cache;
 class Textblock;
 
 class Textpage : public Rectangle
   {
   const std::string name;
   std::vector< Textblock * > tbpv;
+  std::vector< Textblock * > unfiltered;	// blocks before filters
+  long long memory_peak_;		// estimated, in bytes
+  bool unfiltered_kept;
 
   Textpage( const Textpage & );			// declared as private
   void operator=( const Textpage & );		// declared as private
+  Textpage( const Rectangle & re, const char * const filename )
+    : Rectangle( re ), name( filename ), memory_peak_( 0 ),
+      unfiltered_kept( false ) {}
 
 public:
+  // 'threshold' >= 0 replaces the threshold of 'page_image'.
+  // If 'cache' is not null, 'page_image' is taken as the next frame of
+  // a sequence and only the lines that changed are recognized.
+  // If 'control.keep_unfiltered' is true, a copy of the results is kept
+  // before applying the filters. 'threads' > 0 replaces 'control.threads'.
   Textpage( const Page_image & page_image, const char * const filename,
-            const Control & control, const bool layout );
+            const Control & control, const bool layout,
+            const int threshold = -1, Frame_cache * const cache = 0,
+            const int threads = 0 );
   ~Textpage();
 
+  // Recognizes 'page_image' at each of 'thresholds' (in the units of
+  // Page_image::threshold()) concurrently. 'textpages' receives the
+  // results in the same order, or null if out of memory.
+  static void sweep( const Page_image & page_image, const char * const filename,
+                     const Control & control, const bool layout,
+                     const std::vector< int > & thresholds,
+                     std::vector< Textpage * > & textpages );
+
+  // Reduces 'page_image' until the memory estimated to recognize it
+  // fits in the budget of 'control'. Returns false if it can't fit.
+  static bool fit_memory( Page_image & page_image, const Control & control );
+
+  // Returns the scale (as in Page_image::change_scale) that brings the
+  // estimated text height of 'page_image' to the range best recognized.
+  static int auto_scale( const Page_image & page_image, const Control & control );
+
+  // Replaces the results with those kept before the filters, filtered
+  // now with the filters of 'control'. Returns false if the results
+  // before the filters were not kept.
+  bool apply_filters( const Control & control );
+
   const Textblock & textblock( const int i ) const;
   int textblocks() const { return tbpv.size(); }
   int textlines() const;
   int characters() const;
+  long long memory_peak() const { return memory_peak_; }
+  int score() const;		// aggregate confidence of the results
 
   void print( const Control & control ) const;
   void xprint( const Control & control ) const;
+
+  // Writes or reads back the results, without the images of the
+  // characters. A Textpage loaded can be printed and queried, but not
+  // recognized again.
+  void save( FILE * const f ) const;
+  static Textpage * load( FILE * const f, const char * const filename );
   };
@@ -0,0 +1,96 @@
+/*  GNU Ocrad - Optical Character Recognition program
+    Copyright (C) 2003-2015 Antonio Diaz Diaz.
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 2 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include <cstdio>
+#include <cstdlib>
+#include <vector>
+#include <pthread.h>
+
+#include "common.h"
+#include "trace.h"
+
+
+namespace {
+
+FILE * file = 0;
+long long origin = 0;			// time of open, in nanoseconds
+bool first_event = true;
+bool registered = false;		// close registered with atexit
+pthread_mutex_t mutex = PTHREAD_MUTEX_INITIALIZER;
+std::vector< pthread_t > thread_ids;	// tid - 1 of each known thread
+
+
+int thread_number()			// mutex must be locked
+  {
+  const pthread_t self = pthread_self();
+  for( unsigned i = 0; i < thread_ids.size(); ++i )
+    if( pthread_equal( thread_ids[i], self ) ) return i + 1;
+  thread_ids.push_back( self );
+  return thread_ids.size();
+  }
+
+
+void close_at_exit() { Trace::close(); }
+
+} // end namespace
+
+
+bool Trace::enabled = false;
+
+
+bool Trace::open( const char * const filename )
+  {
+  close();
+  FILE * const f = std::fopen( filename, "w" );
+  if( !f ) return false;
+  pthread_mutex_lock( &mutex );
+  file = f; origin = Ocrad::nanoseconds(); first_event = true;
+  thread_ids.clear();
+  std::fputs( "[", file );
+  if( !registered ) { std::atexit( close_at_exit ); registered = true; }
+  enabled = true;
+  pthread_mutex_unlock( &mutex );
+  return true;
+  }
+
+
+void Trace::close()
+  {
+  pthread_mutex_lock( &mutex );
+  enabled = false;
+  if( file ) { std::fputs( "\n]\n", file ); std::fclose( file ); file = 0; }
+  pthread_mutex_unlock( &mutex );
+  }
+
+
+void Trace::write( const char * const name, const int index,
+                   const long long start )
+  {
+  const long long end = Ocrad::nanoseconds();
+  pthread_mutex_lock( &mutex );
+  if( file )
+    {
+    std::fprintf( file, "%s\n{\"name\":\"%s\",\"ph\":\"X\",\"pid\":1,"
+                  "\"tid\":%d,\"ts\":%.3f,\"dur\":%.3f",
+                  first_event ? "" : ",", name, thread_number(),
+                  ( start - origin ) / 1000.0, ( end - start ) / 1000.0 );
+    if( index >= 0 ) std::fprintf( file, ",\"args\":{\"index\":%d}", index );
+    std::fputs( "}", file );
+    first_event = false;
+    }
+  pthread_mutex_unlock( &mutex );
+  }
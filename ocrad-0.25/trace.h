@@ -0,0 +1,52 @@
+/*  GNU Ocrad - Optical Character Recognition program
+    Copyright (C) 2003-2015 Antonio Diaz Diaz.
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 2 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+// Opt-in tracing of the stages of recognition. Spans are written as
+// complete events in the Chrome trace event format, which can be loaded
+// in chrome://tracing or in Perfetto. Each event is tagged with a small
+// number identifying the thread that ran it. The trace is shared by all
+// the descriptors of the process.
+//
+namespace Trace {
+
+extern bool enabled;
+
+bool open( const char * const filename );	// false if can't open
+void close();
+void write( const char * const name, const int index,
+            const long long start );
+
+// Records the time from its construction to its destruction, or to the
+// call to 'end', as a span named 'name'. If 'index' >= 0, it is written
+// as an argument of the span, for example the number of a text block.
+class Span
+  {
+  const char * const name;
+  const int index;
+  long long start;
+
+  Span( const Span & );				// declared as private
+  void operator=( const Span & );		// declared as private
+
+public:
+  explicit Span( const char * const n, const int i = -1 )
+    : name( n ), index( i ), start( enabled ? Ocrad::nanoseconds() : 0 ) {}
+  ~Span() { end(); }
+  void end() { if( enabled && start ) write( name, index, start ); start = 0; }
+  };
+
+} // end namespace Trace
@@ -16,11 +16,17 @@
 */
 
 #include <cctype>
+#include <cstring>
+#include <stdint.h>
 
 #include "ucs.h"
 
 
-int UCS::base_letter( const int code )
+namespace {
+
+using namespace UCS;
+
+int slow_base_letter( const int code )
   {
   switch( code )
     {
@@ -93,7 +99,8 @@ int UCS::base_letter( const int code )
   }
 
 
-int UCS::compose( const int letter, const int accent )
+
+int slow_compose( const int letter, const int accent )
   {
   switch( letter )
     {
@@ -161,113 +168,201 @@ int UCS::compose( const int letter, const int accent )
   }
 
 
-bool UCS::isalnum( const int code )
+
+int slow_toupper( const int code )
   {
-  return ( UCS::isalpha( code ) || UCS::isdigit( code ) );
+  if( code < 128 ) return std::toupper( code );
+  switch( code )
+    {
+    case SAGRAVE: return CAGRAVE;
+    case SAACUTE: return CAACUTE;
+    case SACIRCU: return CACIRCU;
+    case SATILDE: return CATILDE;
+    case SADIAER: return CADIAER;
+    case SARING : return CARING;
+    case SCCEDI : return CCCEDI;
+    case SEGRAVE: return CEGRAVE;
+    case SEACUTE: return CEACUTE;
+    case SECIRCU: return CECIRCU;
+    case SEDIAER: return CEDIAER;
+    case SGBREVE: return CGBREVE;
+    case SIGRAVE: return CIGRAVE;
+    case SIACUTE: return CIACUTE;
+    case SICIRCU: return CICIRCU;
+    case SIDIAER: return CIDIAER;
+    case SNTILDE: return CNTILDE;
+    case SOGRAVE: return COGRAVE;
+    case SOACUTE: return COACUTE;
+    case SOCIRCU: return COCIRCU;
+    case SOTILDE: return COTILDE;
+    case SODIAER: return CODIAER;
+    case SSCEDI : return CSCEDI;
+    case SSCARON: return CSCARON;
+    case SUGRAVE: return CUGRAVE;
+    case SUACUTE: return CUACUTE;
+    case SUCIRCU: return CUCIRCU;
+    case SUDIAER: return CUDIAER;
+    case SYACUTE: return CYACUTE;
+    case SYDIAER: return CYDIAER;
+    case SZCARON: return CZCARON;
+    default:      return code;
+    }
   }
 
 
-bool UCS::isalpha( const int code )
+
+// Properties and mappings of the UCS codes below 'size', which include
+// all the letters recognized. They are built once, at program start-up,
+// from the switch functions above; codes outside the tables have no
+// properties and are their own upper case.
+class Tables
   {
-  return ( ( code < 128 && std::isalpha( code ) ) || base_letter( code ) );
-  }
+public:
+  enum { size = 0x180 };
+  enum { alpha = 1 << 0, lower = 1 << 1, upper = 1 << 2, high = 1 << 3,
+         lower_ambiguous = 1 << 4, lower_small = 1 << 5,
+         lower_small_ambiguous = 1 << 6, space = 1 << 7,
+         upper_normal_width = 1 << 8, vowel = 1 << 9 };
+  enum { accents = 5 };		// ' ` ^ : and others
+
+private:
+  uint16_t flags_[size];
+  uint16_t base_letter_[size];
+  uint16_t toupper_[size];
+  uint16_t compose_[128][accents];
+
+public:
+  Tables();
+
+  bool test( const int code, const int flag ) const
+    { return code >= 0 && code < size && ( flags_[code] & flag ); }
+  int base_letter( const int code ) const
+    { return ( code >= 0 && code < size ) ? base_letter_[code] : 0; }
+  int toupper( const int code ) const
+    { return ( code >= 0 && code < size ) ? toupper_[code] : code; }
+  int compose( const int letter, const int accent ) const
+    {
+    if( letter < 0 || letter >= 128 ) return 0;
+    int i;
+    switch( accent )
+      {
+      case '\'': i = 0; break;
+      case '`' : i = 1; break;
+      case '^' : i = 2; break;
+      case ':' : i = 3; break;
+      default  : i = 4;
+      }
+    return compose_[letter][i];
+    }
+  };
 
 
-bool UCS::ishigh( const int code )
+Tables::Tables()
   {
-  if( isupper( code ) || isdigit( code ) ) return true;
-  switch( code )
+  for( int code = 0; code < size; ++code )
     {
-    case 'b': case 'd': case 'f': case 'g': case 'h': case 'i': case 'j':
-    case 'k': case 'l': case 'p': case 'q': case 't': case 'y': case '|':
-      return true;
-    default : return false;
+    const int base = slow_base_letter( code );
+    const bool ascii = ( code > 0 && code < 128 );
+    const bool is_lower = ( ascii && std::islower( code ) ) ||
+                          ( base && std::islower( base ) );
+    const bool is_upper = ( ascii && std::isupper( code ) ) ||
+                          ( base && std::isupper( base ) );
+    int f = 0;
+    if( ( ascii && std::isalpha( code ) ) || base ) f |= alpha;
+    if( is_lower ) f |= lower;
+    if( is_upper ) f |= upper;
+    if( is_upper || UCS::isdigit( code ) ||
+        ( ascii && std::strchr( "bdfghijklpqty|", code ) ) ) f |= high;
+    if( ascii && std::islower( code ) )
+      {
+      if( std::strchr( "acemnorsuvwxz", code ) ) f |= lower_small;
+      if( std::strchr( "cosuvwxz", code ) ) f |= lower_small_ambiguous;
+      }
+    switch( code )
+      {
+      case 'k': case 'p': case SCCEDI:
+      case SIGRAVE: case SIACUTE: case SICIRCU: case SIDIAER:
+      case SOGRAVE: case SOACUTE: case SOCIRCU: case SOTILDE: case SODIAER:
+      case SUGRAVE: case SUACUTE: case SUCIRCU: case SUDIAER:
+      case  SSCEDI: case SSCARON: case SZCARON:
+        f |= lower_ambiguous;
+      }
+    if( f & lower_small_ambiguous ) f |= lower_ambiguous;
+    if( ( ascii && std::isspace( code ) ) || code == 0xA0 ) f |= space;
+    if( ascii && std::isupper( code ) && !std::strchr( "IJLMQW", code ) )
+      f |= upper_normal_width;
+    const int b = ( code >= 128 ) ? base : code;
+    if( b > 0 && b < 128 && std::isalpha( b ) &&
+        std::strchr( "aeiou", std::tolower( b ) ) ) f |= vowel;
+    flags_[code] = f;
+    base_letter_[code] = base;
+    toupper_[code] = slow_toupper( code );
     }
+  static const int accent_code[accents] = { '\'', '`', '^', ':', 0 };
+  for( int letter = 0; letter < 128; ++letter )
+    for( int i = 0; i < accents; ++i )
+      compose_[letter][i] = slow_compose( letter, accent_code[i] );
   }
 
+const Tables tables;
+
+} // end namespace
+
+
+int UCS::base_letter( const int code )
+  { return tables.base_letter( code ); }
+
+
+int UCS::compose( const int letter, const int accent )
+  { return tables.compose( letter, accent ); }
+
+
+bool UCS::isalnum( const int code )
+  { return tables.test( code, Tables::alpha ) || UCS::isdigit( code ); }
+
+
+bool UCS::isalpha( const int code )
+  { return tables.test( code, Tables::alpha ); }
+
+
+bool UCS::ishigh( const int code )
+  { return tables.test( code, Tables::high ); }
+
 
 bool UCS::islower( const int code )
-  {
-  if( code < 128 && std::islower( code ) ) return true;
-  const int base = base_letter( code );
-  return ( base && std::islower( base ) );
-  }
+  { return tables.test( code, Tables::lower ); }
 
 
 bool UCS::islower_ambiguous( const int code )
-  {
-  if( islower_small_ambiguous( code ) ) return true;
-  switch( code )
-    {
-    case 'k': case 'p': case SCCEDI:
-    case SIGRAVE: case SIACUTE: case SICIRCU: case SIDIAER:
-    case SOGRAVE: case SOACUTE: case SOCIRCU: case SOTILDE: case SODIAER:
-    case SUGRAVE: case SUACUTE: case SUCIRCU: case SUDIAER:
-    case  SSCEDI: case SSCARON: case SZCARON:
-      return true;
-    default : return false;
-    }
-  }
+  { return tables.test( code, Tables::lower_ambiguous ); }
 
 
 bool UCS::islower_small( const int code )
-  {
-  if( code >= 128 || !std::islower( code ) ) return false;
-  switch( code )
-    {
-    case 'a': case 'c': case 'e': case 'm': case 'n': case 'o':
-    case 'r': case 's': case 'u': case 'v': case 'w': case 'x':
-    case 'z': return true;
-    default : return false;
-    }
-  }
+  { return tables.test( code, Tables::lower_small ); }
 
 
 bool UCS::islower_small_ambiguous( const int code )
-  {
-  if( code >= 128 || !std::islower( code ) ) return false;
-  switch( code )
-    {
-    case 'c': case 'o': case 's': case 'u': case 'v': case 'w':
-    case 'x': case 'z': return true;
-    default : return false;
-    }
-  }
+  { return tables.test( code, Tables::lower_small_ambiguous ); }
 
 
 bool UCS::isspace( const int code )
-  {
-  return ( code < 128 && std::isspace( code ) ) || code == 0xA0;
-  }
+  { return tables.test( code, Tables::space ); }
 
 
 bool UCS::isupper( const int code )
-  {
-  if( code < 128 && std::isupper( code ) ) return true;
-  const int base = base_letter( code );
-  return ( base && std::isupper( base ) );
-  }
+  { return tables.test( code, Tables::upper ); }
 
 
 bool UCS::isupper_normal_width( const int code )
-  {
-  if( code >= 128 || !std::isupper( code ) ) return false;
-  switch( code )
-    {
-    case 'I': case 'J': case 'L': case 'M': case 'Q': case 'W': return false;
-    default : return true;
-    }
-  }
+  { return tables.test( code, Tables::upper_normal_width ); }
 
 
-bool UCS::isvowel( int code )
-  {
-  if( code >= 128 ) code = base_letter( code );
-  if( !code || !std::isalpha( code ) ) return false;
-  code = std::tolower( code );
-  return ( code == 'a' || code == 'e' || code == 'i' ||
-           code == 'o' || code == 'u' );
-  }
+bool UCS::isvowel( const int code )
+  { return tables.test( code, Tables::vowel ); }
+
+
+int UCS::toupper( const int code )
+  { return tables.toupper( code ); }
 
 
 unsigned char UCS::map_to_byte( const int code )
@@ -410,42 +505,3 @@ int UCS::to_nearest_upper_num( const int code )
   }
 
 
-int UCS::toupper( const int code )
-  {
-  if( code < 128 ) return std::toupper( code );
-  switch( code )
-    {
-    case SAGRAVE: return CAGRAVE;
-    case SAACUTE: return CAACUTE;
-    case SACIRCU: return CACIRCU;
-    case SATILDE: return CATILDE;
-    case SADIAER: return CADIAER;
-    case SARING : return CARING;
-    case SCCEDI : return CCCEDI;
-    case SEGRAVE: return CEGRAVE;
-    case SEACUTE: return CEACUTE;
-    case SECIRCU: return CECIRCU;
-    case SEDIAER: return CEDIAER;
-    case SGBREVE: return CGBREVE;
-    case SIGRAVE: return CIGRAVE;
-    case SIACUTE: return CIACUTE;
-    case SICIRCU: return CICIRCU;
-    case SIDIAER: return CIDIAER;
-    case SNTILDE: return CNTILDE;
-    case SOGRAVE: return COGRAVE;
-    case SOACUTE: return COACUTE;
-    case SOCIRCU: return COCIRCU;
-    case SOTILDE: return COTILDE;
-    case SODIAER: return CODIAER;
-    case SSCEDI : return CSCEDI;
-    case SSCARON: return CSCARON;
-    case SUGRAVE: return CUGRAVE;
-    case SUACUTE: return CUACUTE;
-    case SUCIRCU: return CUCIRCU;
-    case SUDIAER: return CUDIAER;
-    case SYACUTE: return CYACUTE;
-    case SYDIAER: return CYDIAER;
-    case SZCARON: return CZCARON;
-    default:      return code;
-    }
-  }
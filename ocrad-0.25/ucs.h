@@ -125,7 +125,7 @@ bool islower_small_ambiguous( const int code );
 bool isspace( const int code );
 bool isupper( const int code );
 bool isupper_normal_width( const int code );
-bool isvowel( int code );
+bool isvowel( const int code );
 unsigned char map_to_byte( const int code );
 int map_to_ucs( const unsigned char ch );	// ISO-8859-15 to UCS
 const char * ucs_to_utf8( const int code );
@@ -252,10 +252,16 @@ int User_filter::get_new_code( const int code ) const
   if( code >= 0 )
     {
     if( code < 256 ) result = table1[code];
-    else
+    else					// table2 is sorted by code
       {
-      for( unsigned i = 0; i < table2.size(); ++i )
-        if( code == table2[i].code ) { result = table2[i].new_code; break; }
+      unsigned l = 0, r = table2.size();
+      while( l < r )
+        {
+        const unsigned m = ( l + r ) / 2;
+        if( table2[m].code < code ) l = m + 1; else r = m;
+        }
+      if( l < table2.size() && table2[l].code == code )
+        result = table2[l].new_code;
       }
     }
   if( result < 0 && default_ == d_leave ) result = code;
@@ -0,0 +1,32 @@
+// Loads the fastest build of Ocrad.js that can run here: ocrad-wasm.js if
+// WebAssembly is available, and the asm.js build ocrad.js otherwise, or
+// if ocrad-wasm.js wasn't built.
+// In a page, where scripts can't be loaded synchronously, it only sets
+// OCRAD_BUILD to the name of the build to load.
+// The threaded build ocrad-mt.js is never chosen here, as it has not been
+// run through bench.js yet. Load it directly to try it; in a worker, set
+// OCRAD_SCRIPT_URL to its URL before importScripts so that its threads
+// can start.
+(function(){
+	var builds = ['ocrad.js'];
+	if(typeof WebAssembly == 'object') builds.unshift('ocrad-wasm.js');
+
+	if(typeof module != 'undefined' && module.exports){
+		for(var i = 0; i < builds.length; i++){
+			try {
+				var ocrad = require('./' + builds[i]);
+				ocrad.preinit(); // instantiate the module now to see if it starts
+				ocrad.build = builds[i];
+				module.exports = ocrad;
+				return;
+			} catch (e) { // not built, or failed to start
+				if(i == builds.length - 1) throw e;
+			}
+		}
+	}else if(typeof importScripts == 'function'){
+		for(var i = 0; i < builds.length; i++){
+			try { importScripts(builds[i]); OCRAD.preinit(); OCRAD.build = builds[i]; return; }
+			catch (e) { if(i == builds.length - 1) throw e; }
+		}
+	}else OCRAD_BUILD = builds[0];
+})();
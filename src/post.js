@@ -1,14 +1,23 @@
 	var API = {};
-	function _simple(image, opt){
-		// for converting canvas image data into pnm format
-		if(image.data){
-			var width     = image.width, height = image.height, src = image.data;
-			var header    = "P5\n" + width + " " + height + "\n255\n";
-			var j         = header.length;
-			var dst       = new Uint8Array(j + width * height);
+	var heap_image = 0, heap_image_size = 0; // reused between calls
+
+	// Copies pixel data (like canvas ImageData) straight into the heap and
+	// sets it as the image of desc. RGBA pixels are converted to grey, one
+	// byte per pixel is taken as grey and three bytes as RGB.
+	function set_image_data(desc, image, invert){
+		var width = image.width, height = image.height, src = image.data;
+		var pixels = width * height, channels = pixels > 0 ? src.length / pixels : 0;
+		if(channels != 1 && channels != 3 && channels != 4) throw "Invalid image data";
+		var size = (channels == 3 ? 3 * pixels : pixels) + 3 & ~3;
+		if(heap_image_size < size + 16){
+			if(heap_image) Module._free(heap_image);
+			heap_image = Module._malloc(size + 16);
+			heap_image_size = heap_image ? size + 16 : 0;
+			if(!heap_image) throw "Not enough memory";
+		}
+		var dst = Module.HEAPU8, j = heap_image;
+		if(channels == 4){
 			var srcLength = src.length | 0, srcLength_16 = (srcLength - 16) | 0;
-			
-			for(var i = 0; i < j; i++) dst[i] = header.charCodeAt(i); // write the header
 			var coeff_r = 4899, coeff_g = 9617, coeff_b = 1868;
 
 			for (var i = 0; i <= srcLength_16; i += 16, j += 4) { // convert to grayscale 4 pixels at a time
@@ -19,58 +28,102 @@
 			}
 			for (; i < srcLength; i += 4, ++j)
 				dst[j] = (src[i] * coeff_r + src[i+1] * coeff_g + src[i+2] * coeff_b + 8192) >> 14;
-			image = dst;
-		}
-		// for pnm buffers
-		if(image instanceof ArrayBuffer) image = new Uint8Array(image);
-		API.write_file('/in.pnm', image);
+		}else dst.set(src, heap_image);
+		// struct OCRAD_Pixmap { data, height, width, mode }
+		var pixmap = (heap_image + size) >> 2;
+		Module.HEAP32[pixmap]     = heap_image;
+		Module.HEAP32[pixmap + 1] = height;
+		Module.HEAP32[pixmap + 2] = width;
+		Module.HEAP32[pixmap + 3] = channels == 3 ? 2 : 1; // OCRAD_colormap : OCRAD_greymap
+		return API.set_image(desc, pixmap << 2, invert ? 1 : 0);
+	}
 
-		var desc = API.open();
-		API.set_image_from_file(desc, '/in.pnm', opt.invert ? 1 : 0);
+	function _simple(image, opt){
+		var desc = API.open(), written = false, exported = false, done = false, ret;
+		try{
+			if(image.data){
+				// for canvas image data, no pnm encoding or file needed
+				if(set_image_data(desc, image, opt.invert) < 0) throw "Error setting image";
+			}else{
+				// for pnm buffers
+				if(image instanceof ArrayBuffer) image = new Uint8Array(image);
+				API.write_file('/in.pnm', image);
+				written = true;
+				API.set_image_from_file(desc, '/in.pnm', opt.invert ? 1 : 0);
+			}
 
-		if(opt.raw) API.set_exportfile(desc, '/out.txt');
+			if(opt.raw){
+				if(API.set_exportfile(desc, '/out.txt') < 0) throw "Error opening export file";
+				exported = true;
+			}
 
-		if(opt.filters){
-			(opt.filters.forEach ? opt.filters : [opt.filters]).forEach(function(filter_name){
-				if(["letters", "letters_only", "numbers", "numbers_only", "same_height", "upper_num", "upper_num_only"].indexOf(filter_name) != -1){
-					API.add_filter(desc, filter_name);	
-				}else throw "Invalid Filter";
-			})
-		}
-		if(opt.transform){
-	 		if(["none", "rotate90", "rotate180", "rotate270", "mirror_lr", "mirror_tb", "mirror_d1", "mirror_d2"].indexOf(opt.transform) != -1){
-	 			API.transform(desc, opt.transform);
-	 		}else throw "Invalid transformation!";
-		}
-		if(opt.scale){
-			if(API.scale(desc, Math.round(opt.scale)) < 0)
-	      throw "Error scaling image";
-		}
-		API.set_utf8_format(desc, 1);
-		API.recognize(desc, 0);
+			if(opt.filters){
+				(opt.filters.forEach ? opt.filters : [opt.filters]).forEach(function(filter_name){
+					if(["letters", "letters_only", "numbers", "numbers_only", "same_height", "upper_num", "upper_num_only"].indexOf(filter_name) != -1){
+						API.add_filter(desc, filter_name);	
+					}else throw "Invalid Filter";
+				})
+			}
+			if(opt.transform){
+		 		if(["none", "rotate90", "rotate180", "rotate270", "mirror_lr", "mirror_tb", "mirror_d1", "mirror_d2"].indexOf(opt.transform) != -1){
+		 			API.transform(desc, opt.transform);
+		 		}else throw "Invalid transformation!";
+			}
+			if(opt.adaptive){
+				if(API.set_adaptive_threshold(desc, opt.adaptive === true ? 41 : opt.adaptive) < 0)
+					throw "Invalid adaptive window";
+			}
+			if(opt.scale == 'auto'){
+				if(API.auto_scale(desc) < 0)
+		      throw "Error scaling image";
+			}else if(opt.scale){
+				if(API.scale(desc, Math.round(opt.scale)) < 0)
+		      throw "Error scaling image";
+			}
+			if(opt.quality){
+				var level = ["fast", "thorough"].indexOf(opt.quality);
+				if(level == -1) throw "Invalid quality level";
+				API.set_quality(desc, level);
+			}
+			if(opt.threads !== undefined && API.set_threads(desc, opt.threads) < 0)
+				throw "Invalid number of threads";
+			API.set_utf8_format(desc, 1);
+			if(opt.thresholds){
+				var buf = Module._malloc(4 * opt.thresholds.length);
+				Module.HEAP32.set(opt.thresholds, buf >> 2);
+				var best = API.recognize_sweep(desc, 0, buf, opt.thresholds.length);
+				Module._free(buf);
+				if(best < 0) throw "Error recognizing image";
+			}else API.recognize(desc, 0);
 
-		var ret;
-		if(opt.raw){
-			ret = API.read_text('/out.txt');
-			API.delete_file('/out.txt');
-		}else{
-			var text = '';
-			var block_count = API.result_blocks(desc);
-			
-			for(var i = 0; i < block_count; i++){
-				var line_count = API.result_lines(desc, i);
-				for(var j = 0; j < line_count; j++){
-					var line = API.result_line(desc, i, j);
-					text += line;
+			if(!opt.raw){
+				var text = '';
+				var block_count = API.result_blocks(desc);
+				
+				for(var i = 0; i < block_count; i++){
+					var line_count = API.result_lines(desc, i);
+					for(var j = 0; j < line_count; j++){
+						var line = API.result_line(desc, i, j);
+						text += line;
+					}
 				}
+				ret = text;
+			}
+			done = true;
+		}finally{
+			// closing the descriptor also closes (and flushes) the export file
+			API.close(desc);
+			if(written) API.delete_file('/in.pnm');
+			if(exported){
+				if(done) ret = API.read_text('/out.txt');
+				API.delete_file('/out.txt');
 			}
-			ret = text;
 		}
-		API.close(desc);
-		API.delete_file('/in.pnm');
 		return ret;
 	}
 
+	var result_line_table = Module.cwrap('OCRAD_result_line_table', 'number', ['number', 'number', 'number']);
+
 	// BEGIN API SECTION //
 	API.set_print              = function(fn) { Module.print = fn };
 	API.write_file             = function(filename, arr){ FS.writeFile(filename, arr, {encoding: 'binary'}) };
@@ -82,21 +135,48 @@
 	API.close                  = Module.cwrap('OCRAD_close', 'number', ['number']);
 	API.get_errno              = Module.cwrap('OCRAD_get_errno', 'number', ['number']);
 	API.set_image              = Module.cwrap('OCRAD_set_image', 'number', ['number', 'number', 'number']);
+	API.set_image_data         = set_image_data;
 	API.set_image_from_file    = Module.cwrap('OCRAD_set_image_from_file', 'number', ['number', 'string', 'number']);
+	API.next_image             = Module.cwrap('OCRAD_next_image', 'number', ['number']);
 	API.set_exportfile         = Module.cwrap('OCRAD_set_exportfile', 'number', ['number', 'string']);
 	API.add_filter             = Module.cwrap('OCRAD_add_filter', 'number', ['number', 'string']);
+	API.add_user_filter        = Module.cwrap('OCRAD_add_user_filter', 'number', ['number', 'string']);
+	API.clear_filters          = Module.cwrap('OCRAD_clear_filters', 'number', ['number']);
+	API.apply_filters          = Module.cwrap('OCRAD_apply_filters', 'number', ['number']);
 	API.set_utf8_format        = Module.cwrap('OCRAD_set_utf8_format', 'number', ['number', 'number']);
+	API.set_threads            = Module.cwrap('OCRAD_set_threads', 'number', ['number', 'number']);
+	API.set_despeckle          = Module.cwrap('OCRAD_set_despeckle', 'number', ['number', 'number']);
+	API.set_coarse_layout      = Module.cwrap('OCRAD_set_coarse_layout', 'number', ['number', 'number']);
+	API.set_quality            = Module.cwrap('OCRAD_set_quality', 'number', ['number', 'number']);
+	API.set_trace_file         = Module.cwrap('OCRAD_set_trace_file', 'number', ['number', 'string']);
+	API.set_incremental        = Module.cwrap('OCRAD_set_incremental', 'number', ['number', 'number']);
+	API.set_cache              = Module.cwrap('OCRAD_set_cache', 'number', ['number', 'string', 'number']);
+	API.set_memory_limit       = Module.cwrap('OCRAD_set_memory_limit', 'number', ['number', 'number']);
 	API.set_threshold          = Module.cwrap('OCRAD_set_threshold', 'number', ['number', 'number']);
+	API.set_adaptive_threshold = Module.cwrap('OCRAD_set_adaptive_threshold', 'number', ['number', 'number']);
 	API.scale                  = Module.cwrap('OCRAD_scale', 'number', ['number', 'number']);
+	API.auto_scale             = Module.cwrap('OCRAD_auto_scale', 'number', ['number']);
 	API.transform              = Module.cwrap('OCRAD_transform', 'number', ['number', 'string']);
 	API.recognize              = Module.cwrap('OCRAD_recognize', 'number', ['number', 'number']);
+	API.recognize_sweep        = Module.cwrap('OCRAD_recognize_sweep', 'number', ['number', 'number', 'number', 'number']);
+	API.result_select          = Module.cwrap('OCRAD_result_select', 'number', ['number', 'number']);
+	API.result_score           = Module.cwrap('OCRAD_result_score', 'number', ['number']);
 	API.result_blocks          = Module.cwrap('OCRAD_result_blocks', 'number', ['number']);
 	API.result_lines           = Module.cwrap('OCRAD_result_lines', 'number', ['number', 'number']);
 	API.result_chars_total     = Module.cwrap('OCRAD_result_chars_total', 'number', ['number']);
 	API.result_chars_block     = Module.cwrap('OCRAD_result_chars_block', 'number', ['number', 'number']);
 	API.result_chars_line      = Module.cwrap('OCRAD_result_chars_line', 'number', ['number', 'number', 'number']);
 	API.result_line            = Module.cwrap('OCRAD_result_line', 'string', ['number', 'number', 'number']);
+	// a view of the 7 columns of the line in the heap, not a copy; it is
+	// valid until the results change or the heap grows
+	API.result_line_table      = function(desc, blocknum, linenum){
+		var ptr = result_line_table(desc, blocknum, linenum);
+		if(!ptr) return null;
+		var n = API.result_chars_line(desc, blocknum, linenum);
+		return Module.HEAP32.subarray(ptr >> 2, (ptr >> 2) + 7 * n);
+	};
 	API.result_first_character = Module.cwrap('OCRAD_result_first_character', 'number', ['number']);
+	API.result_memory_peak     = Module.cwrap('OCRAD_result_memory_peak', 'number', ['number']);
 	API._simple                = _simple;
 	// END API SECTION //
 
@@ -105,6 +185,7 @@
 
 function createWebWorkerFromString(code){
 	// http://stackoverflow.com/questions/5408406/web-workers-without-a-separate-javascript-file
+	if(typeof Worker == 'undefined') return;
 	var blob;
 	try {
 	    blob = new Blob([code], {type: 'application/javascript'});
@@ -122,6 +203,71 @@ function createWebWorkerFromString(code){
 	return worker;
 }
 
+// URL of this file, to start the workers of the pool and the threads of
+// ocrad-mt.js from. document.currentScript is only set while the file
+// loads. A worker that loads the file with importScripts can set
+// OCRAD_SCRIPT_URL first.
+var script_url = typeof OCRAD_SCRIPT_URL != 'undefined' ? OCRAD_SCRIPT_URL :
+	typeof document != 'undefined' && document.currentScript ? document.currentScript.src :
+	typeof __filename != 'undefined' ? __filename : '';
+
+// Persistent pool of workers. Each worker instantiates the module once
+// and then runs jobs until terminated, so the cost of instantiation is
+// paid only once per worker instead of once per call.
+var workers = [], idle_workers = [], jobs = [], worker_code;
+
+function runJob(job){
+	var data;
+	try { data = { text: OCRAD._simple(job.image, job.opt) } }
+	catch(err) { data = { error: err } }
+	job.done(data);
+}
+
+function workerDone(e){
+	var job = this.job;
+	this.job = null;
+	idle_workers.push(this);
+	dispatchJobs();
+	job.done(e.data);
+}
+
+function workerFailed(e){
+	var job = this.job;
+	this.terminate();
+	workers.splice(workers.indexOf(this), 1);
+	dispatchJobs();
+	if(job) job.done({ error: e.message });
+}
+
+function dispatchJobs(){
+	while(jobs.length){
+		var worker = idle_workers.pop();
+		if(!worker && workers.length < OCRAD.max_workers){
+			// load this file in the worker if its URL is known, as the
+			// threads of ocrad-mt.js can't start from the source alone
+			if(!worker_code) worker_code = (script_url ?
+				'var OCRAD_SCRIPT_URL = ' + JSON.stringify(script_url) + '; ' +
+				'importScripts(OCRAD_SCRIPT_URL); var API = OCRAD; ' :
+				'var API = (' + createOcradInstance.toString() + ')(); ') +
+				'onmessage = function(e){ var data; ' +
+				'try { data = { text: API._simple(e.data.image, e.data.opt) } } ' +
+				'catch(err) { data = { error: String(err) } } postMessage(data) }';
+			worker = createWebWorkerFromString(worker_code);
+			if(worker){
+				worker.onmessage = workerDone;
+				worker.onerror = workerFailed;
+				workers.push(worker);
+			}else if(!workers.length){ // no workers available
+				runJob(jobs.shift()); // pseudo-async
+				continue;
+			}
+		}
+		if(!worker) return; // wait for a busy worker
+		var job = worker.job = jobs.shift();
+		worker.postMessage({ image: job.image, opt: job.opt }, job.transfer);
+	}
+}
+
 function parseOcradResultsFile(raw){
 	var tb;
 	while(!(tb = raw.shift().match(/^total text blocks (\d+)/)));
@@ -181,6 +327,10 @@ var OCRAD = function OCRAD(image, arg1, arg2){
 	// OCRAD(image, invert:boolean, raw:function) -> text
 	// OCRAD(image, options) -> text
 	// OCRAD(image, options, callback) -> promise
+	// callback(text) runs when a worker of the pool is done, or
+	// callback(undefined, error) if it failed. options.transfer moves
+	// the pixels of image to the worker instead of copying them.
+	// options.threads (0 = all processors) only helps with ocrad-mt.js.
 	var opt = {}, async = false, rawfn;
 	if(typeof arg1 == "object"){
 		opt = arg1;
@@ -195,6 +345,7 @@ var OCRAD = function OCRAD(image, arg1, arg2){
 	if(opt.numeric) opt.filters = ["numbers_only"]; 
 	// for functions that may generate images
 	if(typeof image == 'function') image = image();
+	var owned = !!opt.transfer; // pixels may be moved to the worker
 	if(image.getContext){
 		// for <canvas> elements
 		image = image.getContext('2d');
@@ -213,7 +364,10 @@ var OCRAD = function OCRAD(image, arg1, arg2){
 		image = ctx;
 	}
 	// for canvas contexts
-	if(image.getImageData) image = image.getImageData(0, 0, image.canvas.width, image.canvas.height);
+	if(image.getImageData){
+		image = image.getImageData(0, 0, image.canvas.width, image.canvas.height);
+		owned = true;
+	}
 	
 	function postprocess(data){
 		if(rawfn) data.split('\n').forEach(rawfn);
@@ -221,20 +375,17 @@ var OCRAD = function OCRAD(image, arg1, arg2){
 		return data; // plain text probably
 	}
 
-	var worker;
 	if(async){
-		var code = 'var API = (' + createOcradInstance.toString() + ')(); onmessage = function(e){ postMessage(API._simple(e.data.image, e.data.opt)) }';
-		worker = createWebWorkerFromString(code);
-		if(worker){
-			worker.onmessage = function(e){
-				async(postprocess(e.data));
-				worker.terminate();
-				// TODO: perhaps reuse workers?
-			}
-			worker.postMessage({ image: image, opt: opt })
-		}else{
-			async(postprocess(OCRAD._simple(image, opt))); // pseudo-async
-		}
+		var transfer = [];
+		if(image.data){ // plain object, pixels moved instead of copied if owned
+			image = { width: image.width, height: image.height, data: image.data };
+			if(owned) transfer.push(image.data.buffer);
+		}else if(owned) transfer.push(image.buffer || image); // pnm buffer
+		jobs.push({ image: image, opt: opt, transfer: transfer, done: function(data){
+			if(data.error !== undefined) async(undefined, data.error);
+			else async(postprocess(data.text));
+		}});
+		dispatchJobs();
 	}else{
 		return postprocess(OCRAD._simple(image, opt));
 	}
@@ -249,12 +400,29 @@ function fwrap(name){
 	}
 }
 
+OCRAD.max_workers = Math.min(4, (typeof navigator != 'undefined' && navigator.hardwareConcurrency) || 2);
+
+// Terminates the workers of the pool. Jobs still queued are discarded.
+OCRAD.terminate_workers = function(){
+	for(var i = 0; i < workers.length; i++) workers[i].terminate();
+	workers = []; idle_workers = []; jobs = [];
+}
+
 OCRAD.preinit = function(){
 	if(!APISingleton) {
 		APISingleton = createOcradInstance();
 	}
 }
 
+// The threads of ocrad-mt.js load this same file, and take their work
+// from the module once it runs.
+function isThread(){
+	if(typeof importScripts == 'function') return /^em-pthread/.test(self.name);
+	try { return require('worker_threads').workerData == 'em-pthread' }
+	catch (e) { return false }
+}
+if(isThread()) OCRAD.preinit();
+
 // BEGIN AUTOGENERATED //
 OCRAD.set_print                      = fwrap('set_print');
 OCRAD.write_file                     = fwrap('write_file');
@@ -266,21 +434,41 @@ OCRAD.open                           = fwrap('open');
 OCRAD.close                          = fwrap('close');
 OCRAD.get_errno                      = fwrap('get_errno');
 OCRAD.set_image                      = fwrap('set_image');
+OCRAD.set_image_data                 = fwrap('set_image_data');
 OCRAD.set_image_from_file            = fwrap('set_image_from_file');
+OCRAD.next_image                     = fwrap('next_image');
 OCRAD.set_exportfile                 = fwrap('set_exportfile');
 OCRAD.add_filter                     = fwrap('add_filter');
+OCRAD.add_user_filter                = fwrap('add_user_filter');
+OCRAD.clear_filters                  = fwrap('clear_filters');
+OCRAD.apply_filters                  = fwrap('apply_filters');
 OCRAD.set_utf8_format                = fwrap('set_utf8_format');
+OCRAD.set_threads                    = fwrap('set_threads');
+OCRAD.set_despeckle                  = fwrap('set_despeckle');
+OCRAD.set_coarse_layout              = fwrap('set_coarse_layout');
+OCRAD.set_quality                    = fwrap('set_quality');
+OCRAD.set_trace_file                 = fwrap('set_trace_file');
+OCRAD.set_incremental                = fwrap('set_incremental');
+OCRAD.set_cache                      = fwrap('set_cache');
+OCRAD.set_memory_limit               = fwrap('set_memory_limit');
 OCRAD.set_threshold                  = fwrap('set_threshold');
+OCRAD.set_adaptive_threshold         = fwrap('set_adaptive_threshold');
 OCRAD.scale                          = fwrap('scale');
+OCRAD.auto_scale                     = fwrap('auto_scale');
 OCRAD.transform                      = fwrap('transform');
 OCRAD.recognize                      = fwrap('recognize');
+OCRAD.recognize_sweep                = fwrap('recognize_sweep');
+OCRAD.result_select                  = fwrap('result_select');
+OCRAD.result_score                   = fwrap('result_score');
 OCRAD.result_blocks                  = fwrap('result_blocks');
 OCRAD.result_lines                   = fwrap('result_lines');
 OCRAD.result_chars_total             = fwrap('result_chars_total');
 OCRAD.result_chars_block             = fwrap('result_chars_block');
 OCRAD.result_chars_line              = fwrap('result_chars_line');
 OCRAD.result_line                    = fwrap('result_line');
+OCRAD.result_line_table              = fwrap('result_line_table');
 OCRAD.result_first_character         = fwrap('result_first_character');
+OCRAD.result_memory_peak             = fwrap('result_memory_peak');
 OCRAD._simple                        = fwrap('_simple');
 // END AUTOGENERATED //
 
@@ -1,3 +1,7 @@
 var OCRAD = (function(){
 function createOcradInstance(){
 
+	// the instance is created after the file has loaded, when emscripten
+	// can no longer find the script that the threads of ocrad-mt.js start from
+	if(script_url) Module['mainScriptUrlOrBlob'] = script_url;
+